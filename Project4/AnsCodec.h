@@ -0,0 +1,404 @@
+/**************************************************************************************************
+*
+*   File name :			AnsCodec.h
+*
+*   Header file for the ansCodec class template, a table-based asymmetric numeral systems (tANS)
+*	coder with the same interface as codec. Huffman codes take whole bits, so a symbol seen 95%
+*	of the time still costs a bit; tANS spends fractions of a bit by carrying a state between
+*	symbols. Counts are normalized to a table of 2^tableLog states, spread over the table, and
+*	each symbol moves the state while writing only the bits it has to.
+*
+*	entropyCodec wraps a codec and an ansCodec over the same counts so the backend can be picked
+*	per stream or per block at run time, as the stream functions do for each chunk. Like codec,
+*	both allocate their tables through the MemoryAccount they are constructed with.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		ansCodec<Symbol, AlphabetSize>
+*
+*	Structs:
+*		ansDecodeEntry				the symbol, bits to read and next state base for one state
+*		ansEncodeEntry				the shift and table offset that code one symbol
+*
+*	Private data members:
+*		accountedVector freq				the count of each symbol
+*		accountedVector norm				each symbol's share of the table's states
+*		accountedVector symbolTransform		how each symbol moves the encoder state
+*		accountedVector stateTable			the encoder's next states, grouped by symbol
+*		accountedVector decodeTable			the decoder's entry for each state
+*		int tableLog						log2 of the number of states
+*
+*	Private member functions:
+*		bool normalize				scales the counts to shares of the table's states
+*
+*	Public member functions:
+*		ansCodec			constructor for an ansCodec with no symbols counted, allocating
+*							through an account
+*		void reset			clears the counts and tables
+*		void count			adds the symbols of an array to the counts
+*		bool build			normalizes the counts and builds the coding tables
+*		unsigned share		a symbol's share of the table's states
+*		bool setShares		takes stored shares, as saved from share, and builds their tables
+*		codeBits			about the bits encode writes for the symbols counted
+*		size_t encode		packs an array of symbols into bytes
+*		size_t decode		unpacks an array of symbols from packed bits
+*
+****************************************************************************************************/
+#ifndef ANSCODEC_H
+#define ANSCODEC_H
+#include "Codec.h"
+#include <cmath>
+
+//ansDecodeEntry struct holding what the decoder does in one state
+struct ansDecodeEntry
+{
+	unsigned newState;
+	unsigned char bits;
+	unsigned symbol;
+};
+
+//ansEncodeEntry struct holding how the encoder codes one symbol
+struct ansEncodeEntry
+{
+	long long deltaBits;
+	long long deltaState;
+};
+
+//ansCodec class template for symbols from 0 to AlphabetSize - 1
+template <class Symbol, unsigned long long AlphabetSize>
+class ansCodec
+{
+	static_assert(!numeric_limits<Symbol>::is_signed, "ansCodec symbols must be unsigned");
+	static_assert(AlphabetSize > 0 && AlphabetSize - 1 <= numeric_limits<Symbol>::max(),
+		"the alphabet must fit in the symbol type");
+
+public:
+	//smallest and largest tables, as log2 of the number of states
+	static const int MIN_TABLE_LOG = 11;
+	static const int MAX_TABLE_LOG = 20;
+
+	explicit ansCodec(MemoryAccount* account = NULL);
+	void reset();
+	void count(const Symbol* data, size_t size);
+	bool build();
+	unsigned share(Symbol symbol) const;
+	bool setShares(const unsigned* shares);
+	unsigned long long codeBits() const;
+	template <class Allocator>
+	size_t encode(const Symbol* data, size_t size, vector<unsigned char, Allocator>& out) const;
+	size_t decode(const unsigned char* in, size_t bits, Symbol* out, size_t size) const;
+
+private:
+	bool normalize();
+	accountedVector<unsigned long long> freq;
+	accountedVector<unsigned> norm;
+	accountedVector<ansEncodeEntry> symbolTransform;
+	accountedVector<unsigned> stateTable;
+	accountedVector<ansDecodeEntry> decodeTable;
+	int tableLog;
+};
+
+//the table sizes are passed to max by reference, so they need a definition
+template <class Symbol, unsigned long long AlphabetSize>
+const int ansCodec<Symbol, AlphabetSize>::MIN_TABLE_LOG;
+template <class Symbol, unsigned long long AlphabetSize>
+const int ansCodec<Symbol, AlphabetSize>::MAX_TABLE_LOG;
+
+//constructor, the tables allocated through account, or with new when it is NULL
+template <class Symbol, unsigned long long AlphabetSize>
+ansCodec<Symbol, AlphabetSize>::ansCodec(MemoryAccount* account)
+	: freq(accountedAllocator<unsigned long long>(account)),
+	norm(accountedAllocator<unsigned>(account)),
+	symbolTransform(accountedAllocator<ansEncodeEntry>(account)),
+	stateTable(accountedAllocator<unsigned>(account)),
+	decodeTable(accountedAllocator<ansDecodeEntry>(account))
+{
+	reset();
+}
+
+//clears the counts and tables
+template <class Symbol, unsigned long long AlphabetSize>
+void ansCodec<Symbol, AlphabetSize>::reset()
+{
+	freq.assign(AlphabetSize, 0);
+	norm.assign(AlphabetSize, 0);
+	symbolTransform.assign(AlphabetSize, ansEncodeEntry());
+	stateTable.clear();
+	decodeTable.clear();
+	tableLog = MIN_TABLE_LOG;
+}
+
+//adds the symbols of an array to the counts
+template <class Symbol, unsigned long long AlphabetSize>
+void ansCodec<Symbol, AlphabetSize>::count(const Symbol* data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		freq[data[i]]++;
+}
+
+//scales the counts so they add up to the number of states, every counted symbol
+//keeping at least one, returns false if nothing was counted or too many symbols were
+//for the largest table
+template <class Symbol, unsigned long long AlphabetSize>
+bool ansCodec<Symbol, AlphabetSize>::normalize()
+{
+	unsigned long long total = 0;
+	unsigned long long used = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		total += freq[s];
+		if (freq[s] > 0)
+			used++;
+	}
+	if (used == 0)
+		return false;
+
+	//the table needs room for every counted symbol and some precision besides
+	tableLog = max(MIN_TABLE_LOG, bitsFor(used) + 1);
+	if (tableLog > MAX_TABLE_LOG)
+		return false;
+	unsigned long long states = 1ULL << tableLog;
+
+	//round each share down, keeping at least one state
+	unsigned long long assigned = 0;
+	unsigned long long largest = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		norm[s] = 0;
+		if (freq[s] > 0)
+		{
+			norm[s] = (unsigned)max(1.0, (double)freq[s] * states / total);
+			assigned += norm[s];
+			if (norm[s] > norm[largest] || freq[largest] == 0)
+				largest = s;
+		}
+	}
+
+	//the rounding error goes to or comes from the largest shares
+	if (assigned < states)
+	{
+		norm[largest] += (unsigned)(states - assigned);
+		assigned = states;
+	}
+	while (assigned > states)
+	{
+		for (unsigned long long s = 0; s < AlphabetSize; s++)
+		{
+			if (norm[s] > norm[largest])
+				largest = s;
+		}
+		unsigned long long take = min(assigned - states, (unsigned long long)norm[largest] / 2);
+		norm[largest] -= (unsigned)take;
+		assigned -= take;
+	}
+	return true;
+}
+
+//normalizes the counts and builds the encoder and decoder tables,
+//returns false if nothing was counted
+template <class Symbol, unsigned long long AlphabetSize>
+bool ansCodec<Symbol, AlphabetSize>::build()
+{
+	if (!normalize())
+		return false;
+	unsigned states = 1U << tableLog;
+	unsigned mask = states - 1;
+
+	//spread each symbol's states over the table with a step coprime to its size
+	vector<Symbol> spread(states);
+	unsigned step = (states >> 1) + (states >> 3) + 3;
+	unsigned pos = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		for (unsigned i = 0; i < norm[s]; i++)
+		{
+			spread[pos] = (Symbol)s;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	//encoder: each symbol's states in table order, and how to find them
+	vector<unsigned> cumul(AlphabetSize + 1, 0);
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+		cumul[s + 1] = cumul[s] + norm[s];
+	stateTable.assign(states, 0);
+	for (unsigned u = 0; u < states; u++)
+		stateTable[cumul[spread[u]]++] = states + u;
+	unsigned total = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		if (norm[s] == 0)
+			continue;
+		int maxBits = (norm[s] == 1) ? tableLog : tableLog - (bitsFor(norm[s] - 1) - 1);
+		symbolTransform[s].deltaBits = ((long long)maxBits << 32) - ((long long)norm[s] << maxBits);
+		symbolTransform[s].deltaState = (long long)total - norm[s];
+		total += norm[s];
+	}
+
+	//decoder: the symbol in each state and where its next state starts
+	vector<unsigned> next(norm.begin(), norm.end());
+	decodeTable.assign(states, ansDecodeEntry());
+	for (unsigned u = 0; u < states; u++)
+	{
+		unsigned nextState = next[spread[u]]++;
+		decodeTable[u].symbol = spread[u];
+		decodeTable[u].bits = (unsigned char)(tableLog - (bitsFor(nextState) - 1));
+		decodeTable[u].newState = (nextState << decodeTable[u].bits) - states;
+	}
+	return true;
+}
+
+//returns a symbol's share of the table's states, 0 if it was never counted
+template <class Symbol, unsigned long long AlphabetSize>
+unsigned ansCodec<Symbol, AlphabetSize>::share(Symbol symbol) const
+{
+	return norm[symbol];
+}
+
+//takes a share for every symbol and builds the tables build gave them, returns false if
+//they are not shares build could have given, as when they are damaged
+template <class Symbol, unsigned long long AlphabetSize>
+bool ansCodec<Symbol, AlphabetSize>::setShares(const unsigned* shares)
+{
+	//shares that already fill the table normalize to themselves
+	freq.assign(shares, shares + AlphabetSize);
+	if (!build())
+		return false;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		if (norm[s] != shares[s])
+			return false;
+	}
+	return true;
+}
+
+//returns about the bits encode writes for the symbols counted, each costing the log of
+//the table's states over its share
+template <class Symbol, unsigned long long AlphabetSize>
+unsigned long long ansCodec<Symbol, AlphabetSize>::codeBits() const
+{
+	double bits = tableLog;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		if (freq[s] > 0 && norm[s] > 0)
+			bits += freq[s] * (tableLog - log2((double)norm[s]));
+	}
+	return (unsigned long long)ceil(bits);
+}
+
+//packs an array of symbols onto the end of out, the final state first,
+//returns the number of bits or 0 if a symbol was never counted
+template <class Symbol, unsigned long long AlphabetSize>
+template <class Allocator>
+size_t ansCodec<Symbol, AlphabetSize>::encode(const Symbol* data, size_t size,
+	vector<unsigned char, Allocator>& out) const
+{
+	//symbols are coded last to first, so their bits are kept to be written in reverse,
+	//counted with the tables
+	accountedVector<pair<unsigned, unsigned char> > chunks(size, pair<unsigned, unsigned char>(),
+		accountedAllocator<pair<unsigned, unsigned char> >(norm.get_allocator()));
+	unsigned long long state = 1ULL << tableLog;
+	for (size_t i = size; i-- > 0;)
+	{
+		Symbol s = data[i];
+		if (norm[s] == 0)
+			return 0;
+		unsigned bits = (unsigned)((long long)(state + symbolTransform[s].deltaBits) >> 32);
+		chunks[i] = make_pair((unsigned)(state & ((1ULL << bits) - 1)), (unsigned char)bits);
+		state = stateTable[(size_t)((long long)(state >> bits) + symbolTransform[s].deltaState)];
+	}
+
+	//the final state, then each symbol's bits in reading order
+	unsigned long long acc = 0;
+	int pending = 0;
+	size_t written = tableLog;
+	putBits(state - (1ULL << tableLog), tableLog, acc, pending, out);
+	for (size_t i = 0; i < size; i++)
+	{
+		putBits(chunks[i].first, chunks[i].second, acc, pending, out);
+		written += chunks[i].second;
+	}
+	if (pending > 0)
+		out.push_back((unsigned char)(acc << (8 - pending)));
+	return written;
+}
+
+//unpacks up to size symbols from the given number of bits,
+//returns the number of symbols decoded
+template <class Symbol, unsigned long long AlphabetSize>
+size_t ansCodec<Symbol, AlphabetSize>::decode(const unsigned char* in, size_t bits, Symbol* out,
+	size_t size) const
+{
+	if (bits < (size_t)tableLog || decodeTable.empty())
+		return 0;
+	size_t pos = 0;
+	unsigned state = (unsigned)getBits(in, pos, tableLog);
+	size_t decoded = 0;
+	while (decoded < size)
+	{
+		const ansDecodeEntry& entry = decodeTable[state];
+		if (pos + entry.bits > bits)
+			break;
+		out[decoded++] = (Symbol)entry.symbol;
+		state = entry.newState + (unsigned)getBits(in, pos, entry.bits);
+	}
+	return decoded;
+}
+
+//which coder an entropyCodec uses
+enum backend
+{
+	HUFFMAN_BACKEND,
+	ANS_BACKEND
+};
+
+//entropyCodec class template that counts once and codes with either backend
+template <class Symbol, unsigned long long AlphabetSize>
+class entropyCodec
+{
+public:
+	entropyCodec(backend coder = HUFFMAN_BACKEND, MemoryAccount* account = NULL)
+		: huffman(account), ans(account) { this->coder = coder; }
+	void setBackend(backend coder) { this->coder = coder; }
+	backend getBackend() const { return coder; }
+	void reset() { huffman.reset(); ans.reset(); }
+	void count(const Symbol* data, size_t size) { huffman.count(data, size); ans.count(data, size); }
+	bool build() { return huffman.build() && ans.build(); }
+	int codeLength(Symbol symbol) const { return huffman.codeLength(symbol); }
+	bool setLengths(const unsigned char* lengths) { return huffman.setLengths(lengths); }
+	unsigned share(Symbol symbol) const { return ans.share(symbol); }
+	bool setShares(const unsigned* shares) { return ans.setShares(shares); }
+	unsigned long long codeBits(backend coder) const
+	{
+		return (coder == ANS_BACKEND) ? ans.codeBits() : huffman.codeBits();
+	}
+	template <class Allocator>
+	size_t encode(const Symbol* data, size_t size, vector<unsigned char, Allocator>& out) const
+	{
+		return (coder == ANS_BACKEND) ? ans.encode(data, size, out) : huffman.encode(data, size, out);
+	}
+	size_t decode(const unsigned char* in, size_t bits, Symbol* out, size_t size) const
+	{
+		return (coder == ANS_BACKEND) ? ans.decode(in, bits, out, size) : huffman.decode(in, bits, out, size);
+	}
+
+	//the Huffman codes split into streams, which tANS has no form of
+	template <class Allocator>
+	size_t encodeStreams(const Symbol* data, size_t size, int streams,
+		vector<unsigned char, Allocator>& out, size_t* bits) const
+	{
+		return huffman.encodeStreams(data, size, streams, out, bits);
+	}
+	size_t decodeStreams(const unsigned char* in, const size_t* bits, int streams, Symbol* out,
+		size_t size) const
+	{
+		return huffman.decodeStreams(in, bits, streams, out, size);
+	}
+
+private:
+	backend coder;
+	codec<Symbol, AlphabetSize> huffman;
+	ansCodec<Symbol, AlphabetSize> ans;
+};
+
+#endif // !ANSCODEC_H
@@ -0,0 +1,711 @@
+/**************************************************************************************************
+*
+*   File name :			Archive.cpp
+*
+*	Implementation of the Archive class as defined in Archive.h. Creates archives of many text
+*	files coded on several threads, lists them and extracts single members through the index.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#include "Archive.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+using namespace std;
+
+//first bytes of an archive
+const char ARCHIVE_MAGIC[4] = { 'H', 'U', 'F', 'A' };
+
+//flags byte bits set when the members share one code table, and when the index
+//holds checkpoints for each member
+const unsigned char SHARED_TABLE_FLAG = 1;
+const unsigned char CHECKPOINT_FLAG = 2;
+
+//bytes read from a member per block
+const int MEMBER_BLOCK = 65536;
+
+//symbols of a member coded per task, and symbols between a member's checkpoints
+const size_t ARCHIVE_BLOCK = 1 << 20;
+const size_t ARCHIVE_CHECKPOINT = 1 << 16;
+
+//writes the low bytes of a number, least significant first
+static void putNumber(ostream& out, unsigned long long value, int bytes)
+{
+	for (int b = 0; b < bytes; b++)
+		out.put((char)(value >> (8 * b)));
+}
+
+//reads a number written by putNumber
+static unsigned long long getNumber(istream& in, int bytes)
+{
+	unsigned long long value = 0;
+	for (int b = 0; b < bytes; b++)
+		value |= (unsigned long long)(unsigned char)in.get() << (8 * b);
+	return value;
+}
+
+/*******************************************************************************************
+*	Function Name:			Archive				the constructor
+*	Purpose:				Creates an Archive that gives each member its own code table
+*							and codes on as many threads as the machine has
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+Archive::Archive()
+{
+	sharedTable = false;
+	pinned = false;
+	account = NULL;
+	threads = max(1, (int)thread::hardware_concurrency());
+}
+
+/*******************************************************************************************
+*	Function Name:			setSharedTable
+*	Purpose:				Sets whether create codes every member with one table built
+*							from all of them, which saves a table per member when members
+*							are small and alike
+*	Input Parameters:		bool shared			true for one table
+*	Return value:			none
+********************************************************************************************/
+void Archive::setSharedTable(bool shared)
+{
+	sharedTable = shared;
+}
+
+/*******************************************************************************************
+*	Function Name:			setThreads
+*	Purpose:				Sets how many threads create reads and codes members on
+*	Input Parameters:		int threads			the number of threads, at least 1
+*	Return value:			none
+********************************************************************************************/
+void Archive::setThreads(int threads)
+{
+	this->threads = max(1, threads);
+}
+
+/*******************************************************************************************
+*	Function Name:			setPinning
+*	Purpose:				Sets whether create pins each of its threads to one core, so a
+*							thread's buffers stay in that core's caches and, since memory
+*							is placed where it is first written, in its NUMA node
+*	Input Parameters:		bool pinned			true to pin the threads
+*	Return value:			none
+********************************************************************************************/
+void Archive::setPinning(bool pinned)
+{
+	this->pinned = pinned;
+}
+
+/*******************************************************************************************
+*	Function Name:			setMemoryAccount
+*	Purpose:				Sets the account the members' symbols and code and the code
+*							tables allocate through, so a budget on it bounds what coding
+*							an archive takes
+*	Input Parameters:		MemoryAccount* account	the account, NULL to allocate with new
+*	Return value:			none
+********************************************************************************************/
+void Archive::setMemoryAccount(MemoryAccount* account)
+{
+	this->account = account;
+}
+
+/*******************************************************************************************
+*	Function Name:			create
+*	Purpose:				Writes an archive of the given files. Each member is a task on
+*							a work stealing scheduler that reads it, builds its table and
+*							splits it into blocks coded as tasks of their own, so one large
+*							member spreads over every core while many small ones keep the
+*							cores busy between them. Each block's code goes in its own slot,
+*							and the slots are joined in order as the members are written,
+*							followed by the index
+*	Input Parameters:		string archiveName			the archive to write
+*							vector<string> members		the files to put in it
+*	Return value:			bool						false if a member could not be
+*														read or coded, or the archive
+*														written, leaving no archive
+********************************************************************************************/
+bool Archive::create(const string& archiveName, const vector<string>& members)
+{
+	vector<archiveEntry> entries(members.size());
+	accountedAllocator<unsigned char> bytes(account);
+	vector<accountedVector<uint8_t> > symbols(members.size(), accountedVector<uint8_t>(bytes));
+	vector<letterCodec> models(sharedTable ? 0 : members.size(), letterCodec(account));
+	vector<vector<accountedVector<unsigned char> > > blockCodes(members.size());
+	vector<vector<size_t> > blockBits(members.size());
+	vector<vector<vector<size_t> > > blockMarks(members.size());
+	vector<string> errors(members.size());
+	mutex errorLock;
+	Scheduler pool(threads, pinned);
+
+	//an allocation failing in a task would end the process from the worker, so each task
+	//catches it and records it as its member's error, the lock keeping a member's block
+	//tasks from recording it at once
+	auto outOfMemory = [&](size_t m)
+	{
+		lock_guard<mutex> guard(errorLock);
+		errors[m] = "Out of memory, or over the memory budget, reading or coding " + members[m];
+	};
+
+	//codes a member's symbols a block per task, the blocks' code joined in order later
+	letterCodec shared(account);
+	auto codeBlocks = [&](size_t m, const letterCodec* model)
+	{
+		size_t blocks = (symbols[m].size() + ARCHIVE_BLOCK - 1) / ARCHIVE_BLOCK;
+		blockCodes[m].assign(blocks, accountedVector<unsigned char>(bytes));
+		blockBits[m].resize(blocks);
+		blockMarks[m].resize(blocks);
+		for (size_t b = 0; b < blocks; b++)
+		{
+			pool.submit([&, m, b, model]()
+			{
+				try
+				{
+					size_t first = b * ARCHIVE_BLOCK;
+					size_t count = min((size_t)ARCHIVE_BLOCK, symbols[m].size() - first);
+					const uint8_t* data = symbols[m].data() + first;
+					blockBits[m][b] = model->encode(data, count, blockCodes[m][b]);
+
+					//the block's checkpoints, from the code lengths of the symbols before each
+					size_t bits = 0;
+					for (size_t i = 0; i < count; i++)
+					{
+						if (i % ARCHIVE_CHECKPOINT == 0)
+							blockMarks[m][b].push_back(bits);
+						bits += model->codeLength(data[i]);
+					}
+				}
+				catch (const bad_alloc&)
+				{
+					outOfMemory(m);
+				}
+			});
+		}
+	};
+
+	//with a shared table every member is counted first, each worker into its own table
+	if (sharedTable)
+	{
+		vector<letterCodec> counts(pool.size(), letterCodec(account));
+		for (size_t m = 0; m < members.size(); m++)
+		{
+			pool.submit([&, m]()
+			{
+				try
+				{
+					if (readMember(members[m], symbols[m], errors[m]))
+						counts[Scheduler::current()].count(symbols[m].data(), symbols[m].size());
+				}
+				catch (const bad_alloc&)
+				{
+					outOfMemory(m);
+				}
+			});
+		}
+		pool.wait();
+		for (size_t m = 0; m < members.size(); m++)
+		{
+			if (!errors[m].empty())
+			{
+				cout << errors[m] << endl;
+				return false;
+			}
+		}
+
+		//add the workers' counts together
+		for (int w = 0; w < pool.size(); w++)
+			shared.merge(counts[w]);
+		shared.build();
+		for (size_t m = 0; m < members.size(); m++)
+			codeBlocks(m, &shared);
+	}
+	else
+	{
+		//each member's task reads it and builds its table, then hands out its blocks
+		for (size_t m = 0; m < members.size(); m++)
+		{
+			pool.submit([&, m]()
+			{
+				try
+				{
+					if (!readMember(members[m], symbols[m], errors[m]) || symbols[m].empty())
+						return;
+					models[m].count(symbols[m].data(), symbols[m].size());
+					models[m].build();
+					codeBlocks(m, &models[m]);
+				}
+				catch (const bad_alloc&)
+				{
+					outOfMemory(m);
+				}
+			});
+		}
+	}
+	pool.wait();
+	for (size_t m = 0; m < members.size(); m++)
+	{
+		if (!errors[m].empty())
+		{
+			cout << errors[m] << endl;
+			return false;
+		}
+		for (size_t b = 0; b < blockBits[m].size(); b++)
+		{
+			if (blockBits[m][b] == 0)
+			{
+				cout << "Error coding " << members[m] << endl;
+				return false;
+			}
+		}
+		archiveEntry& entry = entries[m];
+		entry.name = members[m];
+		entry.characters = symbols[m].size();
+		memset(entry.lengths, 0, sizeof(entry.lengths));
+		if (!sharedTable && !symbols[m].empty())
+		{
+			for (int c = 0; c < ALPHABET_SIZE; c++)
+				entry.lengths[c] = (unsigned char)models[m].codeLength((uint8_t)c);
+		}
+		accountedVector<uint8_t>(bytes).swap(symbols[m]);
+	}
+
+	ofstream outFile;
+	outFile.open(archiveName, ios::binary);
+	if (!outFile)
+	{
+		cout << "Error opening file " << archiveName << endl;
+		return false;
+	}
+
+	//a write failing, or memory running out joining a member's blocks, leaves no partial
+	//archive behind
+	streamoff archiveSize = 0;
+	string failure;
+	try
+	{
+		//header, with the index offset written again once it is known
+		outFile.write(ARCHIVE_MAGIC, 4);
+		outFile.put((char)(CHECKPOINT_FLAG | (sharedTable ? SHARED_TABLE_FLAG : 0)));
+		if (sharedTable)
+		{
+			for (int c = 0; c < ALPHABET_SIZE; c++)
+				outFile.put((char)shared.codeLength((uint8_t)c));
+		}
+		streamoff indexField = outFile.tellp();
+		putNumber(outFile, 0, 8);
+
+		//members in the order given, each one's blocks joined into one stream of code
+		for (size_t m = 0; m < members.size(); m++)
+		{
+			accountedVector<unsigned char> code(bytes);
+			size_t bits = 0;
+			for (size_t b = 0; b < blockCodes[m].size(); b++)
+			{
+				for (size_t c = 0; c < blockMarks[m][b].size(); c++)
+					entries[m].checkpoints.push_back({ b * ARCHIVE_BLOCK + c * ARCHIVE_CHECKPOINT,
+						bits + blockMarks[m][b][c] });
+				appendBits(code, bits, blockCodes[m][b].data(), blockBits[m][b]);
+				accountedVector<unsigned char>(bytes).swap(blockCodes[m][b]);
+			}
+			entries[m].offset = (unsigned long long)outFile.tellp();
+			entries[m].bytes = code.size();
+			entries[m].bits = bits;
+			outFile.write((const char*)code.data(), (streamsize)code.size());
+		}
+
+		//the index, then its offset in the header
+		unsigned long long indexOffset = (unsigned long long)outFile.tellp();
+		putNumber(outFile, entries.size(), 4);
+		for (size_t m = 0; m < entries.size(); m++)
+		{
+			putNumber(outFile, entries[m].name.size(), 2);
+			outFile.write(entries[m].name.data(), (streamsize)entries[m].name.size());
+			putNumber(outFile, entries[m].offset, 8);
+			putNumber(outFile, entries[m].bytes, 8);
+			putNumber(outFile, entries[m].bits, 8);
+			putNumber(outFile, entries[m].characters, 8);
+			if (!sharedTable)
+				outFile.write((const char*)entries[m].lengths, ALPHABET_SIZE);
+			putNumber(outFile, entries[m].checkpoints.size(), 4);
+			for (size_t c = 0; c < entries[m].checkpoints.size(); c++)
+			{
+				putNumber(outFile, entries[m].checkpoints[c].symbol, 8);
+				putNumber(outFile, entries[m].checkpoints[c].bit, 8);
+			}
+		}
+		archiveSize = outFile.tellp();
+		outFile.seekp(indexField);
+		putNumber(outFile, indexOffset, 8);
+	}
+	catch (const bad_alloc&)
+	{
+		failure = "Out of memory, or over the memory budget, writing " + archiveName;
+	}
+	outFile.close();
+	if (!failure.empty() || !outFile)
+	{
+		remove(archiveName.c_str());
+		cout << (failure.empty() ? "Error writing " + archiveName : failure) << endl;
+		return false;
+	}
+	cout << members.size() << " files archived in " << archiveName << ", " << archiveSize
+		<< " bytes" << endl;
+	return true;
+}
+
+/*******************************************************************************************
+*	Function Name:			list
+*	Purpose:				Prints the name and sizes of each member of an archive
+*	Input Parameters:		string archiveName		the archive to list
+*	Return value:			none
+********************************************************************************************/
+void Archive::list(const string& archiveName)
+{
+	ifstream inFile;
+	vector<archiveEntry> entries;
+	letterCodec shared(account);
+	if (!readIndex(inFile, archiveName, entries, shared))
+		return;
+	for (size_t m = 0; m < entries.size(); m++)
+		cout << entries[m].name << ": " << entries[m].characters << " characters in "
+			<< entries[m].bytes << " bytes" << endl;
+	cout << entries.size() << " files" << endl;
+}
+
+/*******************************************************************************************
+*	Function Name:			extract
+*	Purpose:				Decodes one member of an archive into a file, reading only the
+*							index and that member's code
+*	Input Parameters:		string archiveName		the archive
+*							string member			the name of the member
+*							string outName			the file to write the member to
+*	Return value:			bool					false if the member could not be found
+*													or decoded
+********************************************************************************************/
+bool Archive::extract(const string& archiveName, const string& member, const string& outName)
+{
+	ifstream inFile;
+	vector<archiveEntry> entries;
+	letterCodec shared(account);
+	if (!readIndex(inFile, archiveName, entries, shared))
+		return false;
+	size_t m = 0;
+	while (m < entries.size() && entries[m].name != member)
+		m++;
+	if (m == entries.size())
+	{
+		cout << member << " is not in " << archiveName << endl;
+		return false;
+	}
+	const archiveEntry& entry = entries[m];
+
+	letterCodec own(account);
+	const letterCodec* model = memberModel(entry, shared, own);
+	if (model == NULL)
+		return false;
+
+	//seek to the member and decode it
+	accountedVector<unsigned char> code((accountedAllocator<unsigned char>(account)));
+	readCode(inFile, entry, code);
+	accountedVector<uint8_t> symbols((size_t)entry.characters, 0, accountedAllocator<uint8_t>(account));
+	size_t decoded = symbols.empty() ? 0 :
+		model->decode(code.data(), (size_t)entry.bits, symbols.data(), symbols.size());
+	inFile.close();
+	if (decoded != symbols.size())
+	{
+		cout << "Only " << decoded << " of " << symbols.size() << " characters of " << member
+			<< " could be decoded" << endl;
+		return false;
+	}
+
+	//letters back from symbols, ended with the terminating character
+	string text(symbols.size(), ' ');
+	for (size_t i = 0; i < symbols.size(); i++)
+		text[i] = (char)(FIRST_CHAR + symbols[i]);
+	ofstream outFile;
+	outFile.open(outName);
+	outFile << text << '*';
+	outFile.close();
+	cout << member << " extracted to " << outName << endl;
+	return true;
+}
+
+/*******************************************************************************************
+*	Function Name:			search
+*	Purpose:				Finds where a text occurs in the members of an archive without
+*							decoding them. The text is coded with each member's table and
+*							its bits looked for in the member's code; a place the bits occur
+*							is only a match if a code starts there, which is checked by
+*							stepping over codes from the nearest checkpoint before it
+*	Input Parameters:		string archiveName			the archive
+*							string pattern				the text to find, letters only
+*							vector<archiveMatch> matches	each member and character
+*														position the text starts at
+*	Return value:			bool						false if the archive or the text
+*														could not be read
+********************************************************************************************/
+bool Archive::search(const string& archiveName, const string& pattern, vector<archiveMatch>& matches)
+{
+	matches.clear();
+	vector<uint8_t> query;
+	for (size_t i = 0; i < pattern.size(); i++)
+	{
+		if (isspace((unsigned char)pattern[i]))
+			continue;
+		int letter = tolower((unsigned char)pattern[i]) - FIRST_CHAR;
+		if (letter < 0 || letter >= ALPHABET_SIZE)
+		{
+			cout << "Only letters can be searched for" << endl;
+			return false;
+		}
+		query.push_back((uint8_t)letter);
+	}
+	if (query.empty())
+	{
+		cout << "There is nothing to search for" << endl;
+		return false;
+	}
+	ifstream inFile;
+	vector<archiveEntry> entries;
+	letterCodec shared(account);
+	if (!readIndex(inFile, archiveName, entries, shared))
+		return false;
+
+	for (size_t m = 0; m < entries.size(); m++)
+	{
+		const archiveEntry& entry = entries[m];
+		if (entry.characters < query.size())
+			continue;
+		letterCodec own(account);
+		const letterCodec* model = memberModel(entry, shared, own);
+		if (model == NULL)
+			return false;
+
+		//a letter with no code in the member's table cannot be in the member
+		bool coded = true;
+		for (size_t i = 0; i < query.size(); i++)
+			coded = coded && model->codeLength(query[i]) > 0;
+		if (!coded)
+			continue;
+		vector<unsigned char> key;
+		size_t keyBits = model->encode(query.data(), query.size(), key);
+		accountedVector<unsigned char> code((accountedAllocator<unsigned char>(account)));
+		readCode(inFile, entry, code);
+		size_t bits = (size_t)entry.bits;
+
+		//walk holds a place a code starts and the characters before it, moved forward to
+		//each place the bits occur, jumping ahead to a later checkpoint when there is one
+		size_t walk = 0;
+		unsigned long long symbol = 0;
+		size_t mark = 0;
+		for (size_t at = findBits(code.data(), bits, 0, key.data(), keyBits); at < bits;
+			at = findBits(code.data(), bits, at + 1, key.data(), keyBits))
+		{
+			while (mark + 1 < entry.checkpoints.size() && entry.checkpoints[mark + 1].bit <= at)
+				mark++;
+			if (entry.checkpoints[mark].bit > walk)
+			{
+				walk = (size_t)entry.checkpoints[mark].bit;
+				symbol = entry.checkpoints[mark].symbol;
+			}
+			if (walk < at)
+				symbol += model->skip(code.data(), bits, walk, at);
+			if (walk < at)
+			{
+				cout << "The code of " << entry.name << " is damaged" << endl;
+				break;
+			}
+			if (walk == at)
+				matches.push_back({ entry.name, symbol });
+		}
+	}
+	inFile.close();
+	return true;
+}
+
+/*******************************************************************************************
+*	Function Name:			memberModel
+*	Purpose:				Finds the table a member was coded with, building the member's
+*							own table when it has one
+*	Input Parameters:		archiveEntry entry		the member
+*							letterCodec shared		the archive's shared table
+*							letterCodec own			built with the member's own table
+*	Return value:			const letterCodec*		the member's table, NULL if its own
+*													table is damaged
+********************************************************************************************/
+const letterCodec* Archive::memberModel(const archiveEntry& entry, const letterCodec& shared,
+	letterCodec& own)
+{
+	bool ownTable = false;
+	for (int c = 0; c < ALPHABET_SIZE; c++)
+		ownTable = ownTable || entry.lengths[c] > 0;
+	if (!ownTable)
+		return &shared;
+	if (!own.setLengths(entry.lengths))
+	{
+		cout << "The code table of " << entry.name << " is damaged" << endl;
+		return NULL;
+	}
+	return &own;
+}
+
+/*******************************************************************************************
+*	Function Name:			readCode
+*	Purpose:				Reads a member's packed code from an archive
+*	Input Parameters:		ifstream inFile			the archive
+*							archiveEntry entry		the member
+*							accountedVector code	the member's code
+*	Return value:			none
+********************************************************************************************/
+void Archive::readCode(ifstream& inFile, const archiveEntry& entry,
+	accountedVector<unsigned char>& code)
+{
+	code.assign((size_t)entry.bytes, 0);
+	inFile.clear();
+	inFile.seekg((streamoff)entry.offset);
+	inFile.read((char*)code.data(), (streamsize)code.size());
+}
+
+/*******************************************************************************************
+*	Function Name:			readMember
+*	Purpose:				Reads a file up to its terminating character as symbols from
+*							0, skipping whitespace and making everything lowercase like
+*							the Huffman class does. Errors are returned rather than printed
+*							since several threads read at once
+*	Input Parameters:		string fileName			the file to read
+*							accountedVector symbols	the file's letters as symbols
+*							string error			why the file could not be read
+*	Return value:			bool					false if the file could not be opened
+*													or holds a character other than a letter
+********************************************************************************************/
+bool Archive::readMember(const string& fileName, accountedVector<uint8_t>& symbols,
+	string& error)
+{
+	symbols.clear();
+	ifstream inFile;
+	inFile.open(fileName, ios::binary);
+	if (!inFile)
+	{
+		error = "Error opening file " + fileName;
+		return false;
+	}
+	char buffer[MEMBER_BLOCK];
+	while (inFile.read(buffer, MEMBER_BLOCK) || inFile.gcount() > 0)
+	{
+		streamsize count = inFile.gcount();
+		for (streamsize i = 0; i < count; i++)
+		{
+			if (buffer[i] == '*')
+				return true;
+			if (isspace((unsigned char)buffer[i]))
+				continue;
+			int letter = tolower((unsigned char)buffer[i]) - FIRST_CHAR;
+			if (letter < 0 || letter >= ALPHABET_SIZE)
+			{
+				error = fileName + " has a character that cannot be coded";
+				return false;
+			}
+			symbols.push_back((uint8_t)letter);
+		}
+	}
+	return true;
+}
+
+/*******************************************************************************************
+*	Function Name:			readIndex
+*	Purpose:				Opens an archive and reads its header and index
+*	Input Parameters:		ifstream inFile				the archive, left open
+*							string archiveName			the archive's file name
+*							vector<archiveEntry> entries	the members
+*							letterCodec shared			the shared table, if there is one
+*	Return value:			bool						false if the file is not an archive
+********************************************************************************************/
+bool Archive::readIndex(ifstream& inFile, const string& archiveName, vector<archiveEntry>& entries,
+	letterCodec& shared)
+{
+	inFile.open(archiveName, ios::binary);
+	if (!inFile)
+	{
+		cout << "Error opening file " << archiveName << endl;
+		return false;
+	}
+	char magic[4];
+	if (!inFile.read(magic, 4) || memcmp(magic, ARCHIVE_MAGIC, 4) != 0)
+	{
+		cout << archiveName << " is not an archive" << endl;
+		return false;
+	}
+	int flags = inFile.get();
+	bool hasShared = (flags & SHARED_TABLE_FLAG) != 0;
+	unsigned char lengths[ALPHABET_SIZE] = {};
+	if (hasShared)
+	{
+		inFile.read((char*)lengths, ALPHABET_SIZE);
+		if (!shared.setLengths(lengths))
+		{
+			cout << "The code table of " << archiveName << " is damaged" << endl;
+			return false;
+		}
+	}
+
+	//jump over the members to the index. Every count is checked against the bytes the file
+	//has before anything is allocated for it, so a damaged index cannot ask for more
+	unsigned long long indexOffset = getNumber(inFile, 8);
+	unsigned long long membersEnd = (unsigned long long)inFile.tellg();
+	inFile.seekg(0, ios::end);
+	unsigned long long fileSize = (unsigned long long)inFile.tellg();
+	bool damaged = !inFile || indexOffset < membersEnd || indexOffset > fileSize;
+	if (!damaged)
+		inFile.seekg((streamoff)indexOffset);
+
+	//the fewest bytes an entry can take, a name of no characters and no checkpoints
+	unsigned long long entryBytes = 2 + 4 * 8 + (hasShared ? 0 : ALPHABET_SIZE)
+		+ ((flags & CHECKPOINT_FLAG) ? 4 : 0);
+	unsigned long long count = damaged ? 0 : getNumber(inFile, 4);
+	damaged = damaged || !inFile || count > (fileSize - indexOffset - 4) / entryBytes;
+	entries.resize(damaged ? 0 : (size_t)count);
+	for (size_t m = 0; m < entries.size() && !damaged; m++)
+	{
+		archiveEntry& entry = entries[m];
+		entry.name.resize((size_t)getNumber(inFile, 2));
+		if (!entry.name.empty())
+			inFile.read(&entry.name[0], (streamsize)entry.name.size());
+		entry.offset = getNumber(inFile, 8);
+		entry.bytes = getNumber(inFile, 8);
+		entry.bits = getNumber(inFile, 8);
+		entry.characters = getNumber(inFile, 8);
+		memset(entry.lengths, 0, sizeof(entry.lengths));
+		if (!hasShared)
+			inFile.read((char*)entry.lengths, ALPHABET_SIZE);
+
+		//the code lies between the header and the index, and every character takes a bit
+		damaged = !inFile || entry.offset < membersEnd || entry.bytes > indexOffset
+			|| entry.offset > indexOffset - entry.bytes || entry.bits > entry.bytes * 8
+			|| entry.characters > entry.bits;
+
+		//archives written before checkpoints only have the start of each member
+		entry.checkpoints.clear();
+		unsigned long long marks = (!damaged && (flags & CHECKPOINT_FLAG)) ? getNumber(inFile, 4) : 0;
+		damaged = damaged || !inFile || marks > (fileSize - (unsigned long long)inFile.tellg()) / 16;
+		for (size_t c = 0; c < marks && !damaged; c++)
+		{
+			archiveCheckpoint mark;
+			mark.symbol = getNumber(inFile, 8);
+			mark.bit = getNumber(inFile, 8);
+			damaged = mark.symbol > entry.characters || mark.bit > entry.bits;
+			entry.checkpoints.push_back(mark);
+		}
+		if (entry.checkpoints.empty() || entry.checkpoints[0].bit != 0)
+			entry.checkpoints.insert(entry.checkpoints.begin(), { 0, 0 });
+	}
+	if (damaged || !inFile)
+	{
+		cout << "The index of " << archiveName << " is damaged" << endl;
+		return false;
+	}
+	return true;
+}
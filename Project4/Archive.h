@@ -0,0 +1,121 @@
+/**************************************************************************************************
+*
+*   File name :			Archive.h
+*
+*   Header file for the Archive class, implemented in Archive.cpp, which packs many text files
+*	into one archive file. Each member is coded with its own code table, or every member with
+*	one table shared by the whole archive, and the code is packed eight bits a byte. An index
+*	at the end of the archive holds each member's name, offset and sizes, so one member is
+*	extracted by seeking straight to it, and checkpoints where codes start, so a text is
+*	searched for in the members' code without decoding them. Members are read and coded on a
+*	work stealing Scheduler, large members split into blocks. Given a MemoryAccount, the
+*	members' symbols and code and the code tables allocate through it, so they are counted
+*	against its budget.
+*
+*	An archive starts with ARCHIVE_MAGIC, a flags byte, the shared code lengths if there are
+*	any and the offset of the index, then the members' code, then the index. Numbers are
+*	written little-endian.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		Archive
+*
+*	Structs:
+*		archiveCheckpoint			a character of a member and the bit its code starts at
+*		archiveEntry				the name, place, sizes, code lengths and checkpoints of
+*									one member
+*		archiveMatch				a member and character position a searched text starts at
+*
+*	Private data members:
+*		bool sharedTable			whether create codes every member with one table
+*		int threads					the threads create codes members on
+*		bool pinned					whether create pins its threads to cores
+*		MemoryAccount* account		the account buffers and tables allocate through, NULL
+*									for none
+*
+*	Private member functions:
+*		bool readMember				reads a member's letters as symbols
+*		bool readIndex				reads the header and index of an archive
+*		memberModel					the table a member was coded with
+*		void readCode				reads a member's code
+*
+*	Public member functions:
+*		Archive				constructor for an archive with a table per member
+*		setSharedTable		sets whether members share one code table
+*		setThreads			sets the number of threads that code members
+*		setPinning			sets whether the threads are pinned to cores
+*		setMemoryAccount	sets the account buffers and tables allocate through
+*		bool create			writes an archive of the given files
+*		void list			prints the members of an archive
+*		bool extract		decodes one member of an archive to a file
+*		bool search			finds where a text occurs in the members without decoding them
+*
+****************************************************************************************************/
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+#include <string>
+#include <vector>
+#include <fstream>
+#include "Huffman.h"
+#include "Codec.h"
+#include "Scheduler.h"
+#include "Memory.h"
+using namespace std;
+
+//the codec for the Huffman class's letters, as symbols from 0
+typedef codec<uint8_t, ALPHABET_SIZE> letterCodec;
+
+//archiveCheckpoint struct to start decoding a member part way through
+struct archiveCheckpoint
+{
+	unsigned long long symbol;
+	unsigned long long bit;
+};
+
+//archiveEntry struct to find and decode one member of an archive
+struct archiveEntry
+{
+	string name;
+	unsigned long long offset;
+	unsigned long long bytes;
+	unsigned long long bits;
+	unsigned long long characters;
+	unsigned char lengths[ALPHABET_SIZE];
+	vector<archiveCheckpoint> checkpoints;
+};
+
+//archiveMatch struct for where a searched text starts
+struct archiveMatch
+{
+	string member;
+	unsigned long long position;
+};
+
+//archive class for many coded files in one
+class Archive
+{
+public:
+	Archive();
+	void setSharedTable(bool shared);
+	void setThreads(int threads);
+	void setPinning(bool pinned);
+	void setMemoryAccount(MemoryAccount* account);
+	bool create(const string& archiveName, const vector<string>& members);
+	void list(const string& archiveName);
+	bool extract(const string& archiveName, const string& member, const string& outName);
+	bool search(const string& archiveName, const string& pattern, vector<archiveMatch>& matches);
+
+private:
+	bool readMember(const string& fileName, accountedVector<uint8_t>& symbols, string& error);
+	bool readIndex(ifstream& inFile, const string& archiveName, vector<archiveEntry>& entries,
+		letterCodec& shared);
+	const letterCodec* memberModel(const archiveEntry& entry, const letterCodec& shared,
+		letterCodec& own);
+	void readCode(ifstream& inFile, const archiveEntry& entry,
+		accountedVector<unsigned char>& code);
+	bool sharedTable;
+	int threads;
+	bool pinned;
+	MemoryAccount* account;
+};
+#endif // !ARCHIVE_H
@@ -0,0 +1,288 @@
+/**************************************************************************************************
+*
+*   File name :			BitText.h
+*
+*   Header file for the functions that move encoded files between the text form encode writes,
+*	code as '0' and '1' characters ending in '*', and a packed form holding eight code bits per
+*	byte. Packing looks at eight characters at a time as one 64-bit word, checking them and
+*	gathering their bits with a few word operations instead of a branch per character, and the
+*	terminator is found with memchr, which the C library already searches with vector loads.
+*
+*	On x86-64 the byte aligned middle of each is also built for AVX2 and the kernels chosen
+*	once, when first used, from what CPUID says the processor has, so one binary runs the
+*	wide kernels where they exist and the word operations everywhere else. Packing with AVX2
+*	checks 32 characters with one compare and gathers their bits with one movemask, and
+*	unpacking spreads four bytes over 32 characters with one shuffle and compare.
+*
+*	A packed file starts with PACKED_MAGIC, a kind byte, PACKED_CODE for code or PACKED_STORED
+*	for characters stored as they are, and the number of code bits or stored characters as 8
+*	little-endian bytes. The code bits or characters follow.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Functions:
+*		findTerminator			where the terminating '*' is in a block of text
+*		packWordsPortable		packs whole bytes of characters with word operations
+*		packWordsAvx2			packs whole bytes of characters with AVX2
+*		unpackWordsPortable		unpacks whole bytes with word operations
+*		unpackWordsAvx2			unpacks whole bytes with AVX2
+*		bitTextKernel			the kernels the processor runs best, chosen once
+*		packBitText				packs '0' and '1' characters into bytes
+*		unpackBitText			turns packed bits back into '0' and '1' characters
+*		writePackedHeader		writes the header of a packed file
+*		readPackedHeader		reads the header of a packed file if there is one
+*
+****************************************************************************************************/
+#ifndef BITTEXT_H
+#define BITTEXT_H
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+
+//the wide kernels are built where the compiler can target them one function at a time
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define BITTEXT_X86
+#define BITTEXT_TARGET(features) __attribute__((target(features)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define BITTEXT_X86
+#define BITTEXT_TARGET(features)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+using namespace std;
+
+//first bytes of a packed file, and the kinds of packed file
+const char PACKED_MAGIC[4] = { 'H', 'U', 'F', 'P' };
+const char PACKED_CODE = 'C';
+const char PACKED_STORED = '#';
+
+//bytes before the payload of a packed file
+const int PACKED_HEADER = 13;
+
+//returns where the terminating '*' is in a block of text, or size if it is not there
+inline size_t findTerminator(const char* text, size_t size)
+{
+	const void* found = memchr(text, '*', size);
+	return (found == NULL) ? size : (size_t)((const char*)found - text);
+}
+
+//packs whole bytes of '0' and '1' characters into out, eight characters a word, the first
+//going to the top bit of the byte, stopping before a word with another character, returns
+//the number packed
+inline size_t packWordsPortable(const unsigned char* text, size_t size, unsigned char* out)
+{
+	const uint64_t ONES = 0x0101010101010101ULL;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		const unsigned char* p = text + i;
+		uint64_t word = (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16
+			| (uint64_t)p[3] << 24 | (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40
+			| (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+		if ((word & ~ONES) != '0' * ONES)
+			break;
+		out[i >> 3] = (unsigned char)(((word & ONES) * 0x8040201008040201ULL) >> 56);
+	}
+	return i;
+}
+
+//unpacks bytes of in into eight '0' and '1' characters each, a byte copied to all eight
+//characters and masked down to the one bit each shows
+inline void unpackWordsPortable(const unsigned char* in, size_t bytes, unsigned char* out)
+{
+	const uint64_t ONES = 0x0101010101010101ULL;
+	for (size_t b = 0; b < bytes; b++)
+	{
+		uint64_t word = (in[b] * ONES) & 0x0102040810204080ULL;
+		word = (((word + 0x7F7F7F7F7F7F7F7FULL) >> 7) & ONES) + '0' * ONES;
+		unsigned char* at = out + 8 * b;
+		at[0] = (unsigned char)word;
+		at[1] = (unsigned char)(word >> 8);
+		at[2] = (unsigned char)(word >> 16);
+		at[3] = (unsigned char)(word >> 24);
+		at[4] = (unsigned char)(word >> 32);
+		at[5] = (unsigned char)(word >> 40);
+		at[6] = (unsigned char)(word >> 48);
+		at[7] = (unsigned char)(word >> 56);
+	}
+}
+
+#ifdef BITTEXT_X86
+
+//packWordsPortable 32 characters at a time: the characters of each byte are put in reverse
+//order within their 8, so once each low bit is shifted to the top of its character movemask
+//gives four packed bytes, the words left over going through the word operations
+BITTEXT_TARGET("avx2") inline size_t packWordsAvx2(const unsigned char* text, size_t size,
+	unsigned char* out)
+{
+	const __m256i digitBits = _mm256_set1_epi8((char)0xFE);
+	const __m256i zeros = _mm256_set1_epi8('0');
+	const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+		7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i chars = _mm256_loadu_si256((const __m256i*)(text + i));
+		__m256i digits = _mm256_cmpeq_epi8(_mm256_and_si256(chars, digitBits), zeros);
+		if ((uint32_t)_mm256_movemask_epi8(digits) != 0xFFFFFFFFu)
+			break;
+		uint32_t packed = (uint32_t)_mm256_movemask_epi8(
+			_mm256_slli_epi64(_mm256_shuffle_epi8(chars, reverse), 7));
+		memcpy(out + (i >> 3), &packed, 4);
+	}
+	return i + packWordsPortable(text + i, size - i, out + (i >> 3));
+}
+
+//unpackWordsPortable 4 bytes at a time: each byte is copied to its 8 characters, and each
+//character compared with the one bit it shows, which gives -1 for a set bit
+BITTEXT_TARGET("avx2") inline void unpackWordsAvx2(const unsigned char* in, size_t bytes,
+	unsigned char* out)
+{
+	const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	const __m256i shown = _mm256_set1_epi64x((long long)0x0102040810204080ULL);
+	const __m256i zeros = _mm256_set1_epi8('0');
+	size_t b = 0;
+	for (; b + 4 <= bytes; b += 4)
+	{
+		int four;
+		memcpy(&four, in + b, 4);
+		__m256i copies = _mm256_shuffle_epi8(_mm256_set1_epi32(four), spread);
+		__m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(copies, shown), shown);
+		_mm256_storeu_si256((__m256i*)(out + 8 * b), _mm256_sub_epi8(zeros, set));
+	}
+	unpackWordsPortable(in + b, bytes - b, out + 8 * b);
+}
+
+#endif
+
+//bitTextKernels struct holding the kernels packBitText and unpackBitText run
+struct bitTextKernels
+{
+	size_t (*packWords)(const unsigned char* text, size_t size, unsigned char* out);
+	void (*unpackWords)(const unsigned char* in, size_t bytes, unsigned char* out);
+};
+
+//returns the kernels for this processor, asking CPUID the first time only
+inline const bitTextKernels& bitTextKernel()
+{
+	static const bitTextKernels chosen = []()
+	{
+		bitTextKernels kernels = { packWordsPortable, unpackWordsPortable };
+#if defined(BITTEXT_X86) && defined(_MSC_VER)
+		//AVX2 also needs the system to save the vector registers, which xgetbv tells
+		int info[4];
+		__cpuid(info, 0);
+		int leaves = info[0];
+		__cpuid(info, 1);
+		bool vectorsSaved = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		if (leaves >= 7 && vectorsSaved)
+		{
+			__cpuidex(info, 7, 0);
+			if ((info[1] & (1 << 5)) != 0)
+				kernels = { packWordsAvx2, unpackWordsAvx2 };
+		}
+#elif defined(BITTEXT_X86)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			kernels = { packWordsAvx2, unpackWordsAvx2 };
+#endif
+		return kernels;
+	}();
+	return chosen;
+}
+
+//packs '0' and '1' characters onto the end of out, where bits is the number of bits
+//already there, stopping at the first other character, returns the number packed
+inline size_t packBitText(const char* text, size_t size, vector<unsigned char>& out, size_t& bits)
+{
+	out.resize((bits + size + 7) / 8);
+	size_t i = 0;
+
+	//single characters until the output is at a byte boundary
+	for (; i < size && (bits & 7) != 0; i++, bits++)
+	{
+		if ((text[i] & 0xFE) != '0')
+		{
+			out.resize((bits + 7) / 8);
+			return i;
+		}
+		if (text[i] == '1')
+			out[bits >> 3] |= (unsigned char)(0x80 >> (bits & 7));
+	}
+
+	//whole bytes with the processor's kernel
+	size_t words = bitTextKernel().packWords((const unsigned char*)text + i, size - i,
+		out.data() + (bits >> 3));
+	i += words;
+	bits += words;
+
+	//the characters left over
+	for (; i < size; i++)
+	{
+		if ((text[i] & 0xFE) != '0')
+			break;
+		if ((bits & 7) == 0)
+			out[bits >> 3] = 0;
+		if (text[i] == '1')
+			out[bits >> 3] |= (unsigned char)(0x80 >> (bits & 7));
+		bits++;
+	}
+	out.resize((bits + 7) / 8);
+	return i;
+}
+
+//adds count packed bits, starting at bit first of in, onto the end of text as '0' and '1'
+inline void unpackBitText(const unsigned char* in, size_t first, size_t count, string& text)
+{
+	size_t used = text.size();
+	text.resize(used + count);
+	if (count == 0)
+		return;
+	unsigned char* out = (unsigned char*)&text[0] + used;
+	size_t i = 0;
+
+	//single bits until the input is at a byte boundary, then whole bytes with the
+	//processor's kernel
+	for (; i < count && ((first + i) & 7) != 0; i++)
+		out[i] = (unsigned char)('0' + ((in[(first + i) >> 3] >> (7 - ((first + i) & 7))) & 1));
+	size_t bytes = (count - i) / 8;
+	bitTextKernel().unpackWords(in + ((first + i) >> 3), bytes, out + i);
+	i += 8 * bytes;
+	for (; i < count; i++)
+		out[i] = (unsigned char)('0' + ((in[(first + i) >> 3] >> (7 - ((first + i) & 7))) & 1));
+}
+
+//writes the header of a packed file of the given kind and size
+inline void writePackedHeader(ostream& out, char kind, unsigned long long count)
+{
+	char header[PACKED_HEADER];
+	memcpy(header, PACKED_MAGIC, 4);
+	header[4] = kind;
+	for (int b = 0; b < 8; b++)
+		header[5 + b] = (char)(count >> (8 * b));
+	out.write(header, PACKED_HEADER);
+}
+
+//reads the header of a packed file, returns false with the stream back at its start
+//if the file is not packed
+inline bool readPackedHeader(istream& in, char& kind, unsigned long long& count)
+{
+	char header[PACKED_HEADER];
+	if (!in.read(header, PACKED_HEADER) || memcmp(header, PACKED_MAGIC, 4) != 0)
+	{
+		in.clear();
+		in.seekg(0);
+		return false;
+	}
+	kind = header[4];
+	count = 0;
+	for (int b = 0; b < 8; b++)
+		count |= (unsigned long long)(unsigned char)header[5 + b] << (8 * b);
+	return true;
+}
+
+#endif // !BITTEXT_H
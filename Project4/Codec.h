@@ -0,0 +1,955 @@
+/**************************************************************************************************
+*
+*   File name :			Codec.h
+*
+*   Header file for the codec class template, a Huffman coder for any unsigned symbol type with
+*	an alphabet size fixed at compile time. Where the Huffman class codes the letters of a text
+*	file as a string of 0s and 1s, a codec codes arrays of symbols and packs the code into
+*	bytes, so one engine codes bytes, 16-bit samples or dictionary IDs.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		codec<Symbol, AlphabetSize>
+*
+*	Structs:
+*		tableEntry					the whole codes at the start of TABLE_BITS bits of code
+*
+*	The tables are allocated through a MemoryAccount given to the constructor, so a context
+*	can count what its codecs take, or with new when there is none. Code packed onto a vector
+*	goes through that vector's own allocator.
+*
+*	Private data members:
+*		accountedVector freq				the count of each symbol
+*		accountedVector length				the code length of each symbol, 0 if it has no code
+*		accountedVector code				the canonical code of each symbol
+*		accountedVector sorted				the coded symbols in code order
+*		unsigned long long first[]			the first code of each length
+*		unsigned lengthCount[]				the number of codes of each length
+*		unsigned start[]					where each length starts in sorted
+*		int longestCode						the longest code length in use
+*		accountedVector table				the multi-symbol decode table, empty when the
+*											codes are too long on average to use it
+*
+*	Private member functions:
+*		void assignCodes			assigns canonical codes from the code lengths
+*		void buildTable				builds the multi-symbol decode table from the code lengths
+*		bool decodeCode				unpacks one code bit by bit
+*		void minimumRedundancy		turns sorted weights into code lengths in place
+*		bool encodeBits				codes one message of a batch with encode
+*		int batchPut				adds one symbol's code to a batch message, storing whole words
+*
+*	Public member functions:
+*		codec				constructor for a codec with no symbols counted, allocating
+*							through an account
+*		void reset			clears the counts and codes
+*		void count			adds the symbols of an array to the counts
+*		void merge			adds another codec's counts, as from another thread
+*		bool build			computes the code lengths in place after one sort, then the codes
+*		bool setLengths		takes stored code lengths, as saved from codeLength, and their codes
+*		int codeLength		the code length of a symbol
+*		codeBits			the bits encode writes for the symbols counted
+*		size_t encode		packs the codes of an array of symbols into bytes, either onto
+*							a vector or into a caller's buffer without allocating
+*		size_t maxEncodedBytes	the most bytes encode can write for a number of symbols
+*		size_t decode		unpacks an array of symbols from packed code, several symbols
+*							per lookup when the codes are short
+*		size_t skip			steps over whole codes up to a bit, counting the symbols
+*		size_t encodeBatch	codes many messages sharing the codec, a word at a time
+*		size_t decodeBatch	decodes many messages sharing the codec
+*		size_t encodeStreams	codes the parts of an array as separate streams of code
+*		size_t decodeStreams	decodes the streams a turn at a time, each with its own reader,
+*							so their lookups overlap
+*
+*	Functions:
+*		bitsFor						the bits needed to write values up to n
+*		putBits						packs the low bits of a value onto the output bytes
+*		appendBits					joins packed code onto the end of other packed code
+*		getBits						unpacks a value from packed bits
+*		findBits					finds where a run of bits occurs in packed bits
+*
+****************************************************************************************************/
+#ifndef CODEC_H
+#define CODEC_H
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <iostream>
+#include "Memory.h"
+using namespace std;
+
+//bits needed to write values up to n
+constexpr int bitsFor(unsigned long long n)
+{
+	return (n <= 1) ? 1 : 1 + bitsFor(n >> 1);
+}
+
+//packs the low bits of a value onto the output, most significant bit first,
+//keeping fewer than 8 pending bits in the accumulator
+template <class Allocator>
+inline void putBits(unsigned long long value, int bits, unsigned long long& acc, int& pending,
+	vector<unsigned char, Allocator>& out)
+{
+	//more than 56 bits would overflow the accumulator, so write them in two halves
+	if (bits > 32)
+	{
+		putBits(value >> 32, bits - 32, acc, pending, out);
+		value &= 0xFFFFFFFFULL;
+		bits = 32;
+	}
+	acc = (acc << bits) | value;
+	pending += bits;
+	while (pending >= 8)
+	{
+		pending -= 8;
+		out.push_back((unsigned char)(acc >> pending));
+	}
+	acc &= (1ULL << pending) - 1;
+}
+
+//adds packed code of inBits bits onto the end of out, which holds bits bits with its
+//last byte padded with 0s, so code coded in separate blocks joins into one stream
+template <class Allocator>
+inline void appendBits(vector<unsigned char, Allocator>& out, size_t& bits, const unsigned char* in,
+	size_t inBits)
+{
+	size_t inBytes = (inBits + 7) / 8;
+	int shift = (int)(bits & 7);
+	out.resize((bits + 7) / 8);
+	if (shift == 0)
+		out.insert(out.end(), in, in + inBytes);
+	else
+	{
+		for (size_t i = 0; i < inBytes; i++)
+		{
+			out.back() |= (unsigned char)(in[i] >> shift);
+			out.push_back((unsigned char)(in[i] << (8 - shift)));
+		}
+	}
+	bits += inBits;
+	out.resize((bits + 7) / 8);
+}
+
+//unpacks a value of the given number of bits starting at bit pos, moving pos past it
+inline unsigned long long getBits(const unsigned char* in, size_t& pos, int bits)
+{
+	unsigned long long value = 0;
+	for (int i = 0; i < bits; i++, pos++)
+		value = (value << 1) | ((in[pos >> 3] >> (7 - (pos & 7))) & 1);
+	return value;
+}
+
+//finds the first bit at or after from where the patternBits bits of pattern start in the
+//bits bits of in, or returns bits if they are nowhere. Each byte of in is loaded once as the
+//top of a 64-bit word and compared against the pattern's first 56 bits at all 8 shifts
+inline size_t findBits(const unsigned char* in, size_t bits, size_t from, const unsigned char* pattern,
+	size_t patternBits)
+{
+	if (patternBits == 0 || patternBits > bits)
+		return bits;
+	int keyBits = (int)min(patternBits, (size_t)56);
+	size_t keyPos = 0;
+	unsigned long long key = getBits(pattern, keyPos, keyBits);
+	size_t last = bits - patternBits;
+	size_t bytes = (bits + 7) / 8;
+	for (size_t p = from; p <= last; )
+	{
+		//the 64 bits from the byte holding p, read as 0s past the end
+		size_t at = p >> 3;
+		unsigned long long word = 0;
+		for (int b = 0; b < 8; b++)
+			word = (word << 8) | ((at + b < bytes) ? in[at + b] : 0);
+		for (int shift = (int)(p & 7); shift < 8 && p <= last; shift++, p++)
+		{
+			if (((word << shift) >> (64 - keyBits)) != key)
+				continue;
+
+			//bits of a longer pattern past the first 56 are compared one at a time
+			bool same = true;
+			for (size_t i = keyBits; same && i < patternBits; i++)
+				same = ((in[(p + i) >> 3] >> (7 - ((p + i) & 7))) & 1)
+					== ((pattern[i >> 3] >> (7 - (i & 7))) & 1);
+			if (same)
+				return p;
+		}
+	}
+	return bits;
+}
+
+//codec class template for symbols from 0 to AlphabetSize - 1
+template <class Symbol, unsigned long long AlphabetSize>
+class codec
+{
+	static_assert(!numeric_limits<Symbol>::is_signed, "codec symbols must be unsigned");
+	static_assert(AlphabetSize > 0 && AlphabetSize - 1 <= numeric_limits<Symbol>::max(),
+		"the alphabet must fit in the symbol type");
+
+public:
+	//longest code a symbol can be given
+	static const int MAX_LENGTH = 56;
+
+	//spare bytes past maxEncodedBytes that let a batch write whole words
+	static const size_t BATCH_SLACK = 8;
+
+	//bits needed to hold any symbol of the alphabet
+	static const int SYMBOL_BITS = bitsFor(AlphabetSize - 1);
+
+	//bits of code that index the multi-symbol decode table, and the most symbols an entry
+	//holds; 2^11 entries of short symbols stay within a level 1 cache
+	static const int TABLE_BITS = 11;
+	static const int TABLE_SYMBOLS = 4;
+
+	//most streams encodeStreams splits an array into
+	static const int MAX_STREAMS = 8;
+
+	explicit codec(MemoryAccount* account = NULL);
+	void reset();
+	void count(const Symbol* data, size_t size);
+	void merge(const codec& other);
+	bool build();
+	bool setLengths(const unsigned char* lengths);
+	int codeLength(Symbol symbol) const;
+	unsigned long long codeBits() const;
+	template <class Allocator>
+	size_t encode(const Symbol* data, size_t size, vector<unsigned char, Allocator>& out) const;
+	size_t encode(const Symbol* data, size_t size, unsigned char* out, size_t capacity) const;
+	size_t maxEncodedBytes(size_t size) const;
+	size_t decode(const unsigned char* in, size_t bits, Symbol* out, size_t size) const;
+	size_t skip(const unsigned char* in, size_t bits, size_t& pos, size_t last) const;
+	size_t encodeBatch(const Symbol* const* in, const size_t* sizes, size_t count,
+		unsigned char* const* out, const size_t* capacity, size_t* bits) const;
+	size_t decodeBatch(const unsigned char* const* in, const size_t* bits, size_t count,
+		Symbol* const* out, const size_t* sizes, size_t* decoded) const;
+	template <class Allocator>
+	size_t encodeStreams(const Symbol* data, size_t size, int streams,
+		vector<unsigned char, Allocator>& out, size_t* bits) const;
+	size_t decodeStreams(const unsigned char* in, const size_t* bits, int streams, Symbol* out,
+		size_t size) const;
+
+private:
+	//tableEntry struct holding the whole codes that start TABLE_BITS bits of code
+	struct tableEntry
+	{
+		Symbol symbols[TABLE_SYMBOLS];
+		unsigned char count;
+		unsigned char bits;
+	};
+
+	void assignCodes();
+	void buildTable();
+	bool decodeCode(const unsigned char* in, size_t bits, size_t& pos, Symbol& symbol) const;
+	bool encodeBits(const Symbol* data, size_t size, unsigned char* out, size_t capacity,
+		size_t& bits) const;
+	static int batchPut(Symbol s, const unsigned char* lengths, const unsigned long long* codes,
+		unsigned long long& acc, int& pending, size_t& total, unsigned char* out, size_t& written);
+	static void minimumRedundancy(vector<unsigned long long>& A);
+	accountedVector<unsigned long long> freq;
+	accountedVector<unsigned char> length;
+	accountedVector<unsigned long long> code;
+	accountedVector<Symbol> sorted;
+	unsigned long long first[MAX_LENGTH + 1];
+	unsigned lengthCount[MAX_LENGTH + 1];
+	unsigned start[MAX_LENGTH + 1];
+	int longestCode;
+	accountedVector<tableEntry> table;
+};
+
+//the common codecs
+typedef codec<uint8_t, 256> byteCodec;
+typedef codec<uint16_t, 65536> sampleCodec;
+
+//constructor, the tables allocated through account, or with new when it is NULL
+template <class Symbol, unsigned long long AlphabetSize>
+codec<Symbol, AlphabetSize>::codec(MemoryAccount* account)
+	: freq(accountedAllocator<unsigned long long>(account)),
+	length(accountedAllocator<unsigned char>(account)),
+	code(accountedAllocator<unsigned long long>(account)),
+	sorted(accountedAllocator<Symbol>(account)),
+	table(accountedAllocator<tableEntry>(account))
+{
+	reset();
+}
+
+//clears the counts and codes
+template <class Symbol, unsigned long long AlphabetSize>
+void codec<Symbol, AlphabetSize>::reset()
+{
+	freq.assign(AlphabetSize, 0);
+	length.assign(AlphabetSize, 0);
+	code.assign(AlphabetSize, 0);
+	sorted.clear();
+	table.clear();
+	longestCode = 0;
+	for (int i = 0; i <= MAX_LENGTH; i++)
+	{
+		first[i] = 0;
+		lengthCount[i] = 0;
+		start[i] = 0;
+	}
+}
+
+//adds the symbols of an array to the counts
+template <class Symbol, unsigned long long AlphabetSize>
+void codec<Symbol, AlphabetSize>::count(const Symbol* data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		freq[data[i]]++;
+}
+
+//adds another codec's counts to the counts, so separate parts of the input
+//can be counted on separate threads
+template <class Symbol, unsigned long long AlphabetSize>
+void codec<Symbol, AlphabetSize>::merge(const codec& other)
+{
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+		freq[s] += other.freq[s];
+}
+
+//computes the code lengths from the counts and assigns canonical codes,
+//returns false if no symbols have been counted
+template <class Symbol, unsigned long long AlphabetSize>
+bool codec<Symbol, AlphabetSize>::build()
+{
+	//the counts are only copied and halved if the longest code does not fit in MAX_LENGTH
+	accountedVector<unsigned long long> halved(freq.get_allocator());
+	const accountedVector<unsigned long long>* weights = &freq;
+	while (true)
+	{
+		const accountedVector<unsigned long long>& weight = *weights;
+
+		//the counted symbols
+		vector<Symbol> used;
+		for (unsigned long long s = 0; s < AlphabetSize; s++)
+		{
+			length[s] = 0;
+			if (weight[s] > 0)
+				used.push_back((Symbol)s);
+		}
+		if (used.empty())
+			return false;
+
+		//a single symbol still takes one bit
+		if (used.size() == 1)
+		{
+			length[used[0]] = 1;
+			break;
+		}
+
+		//sort the symbols by weight once, as single keys of weight above symbol when the
+		//weights leave room, then turn the weights into code lengths in place
+		vector<unsigned long long> lengths(used.size());
+		unsigned long long heaviest = 0;
+		for (size_t i = 0; i < used.size(); i++)
+			heaviest = max(heaviest, weight[used[i]]);
+		if (heaviest < (1ULL << (64 - SYMBOL_BITS)))
+		{
+			for (size_t i = 0; i < used.size(); i++)
+				lengths[i] = (weight[used[i]] << SYMBOL_BITS) | used[i];
+			sort(lengths.begin(), lengths.end());
+			for (size_t i = 0; i < used.size(); i++)
+			{
+				used[i] = (Symbol)(lengths[i] & ((1ULL << SYMBOL_BITS) - 1));
+				lengths[i] >>= SYMBOL_BITS;
+			}
+		}
+		else
+		{
+			sort(used.begin(), used.end(), [&weight](Symbol x, Symbol y)
+				{ return weight[x] < weight[y] || (weight[x] == weight[y] && x < y); });
+			for (size_t i = 0; i < used.size(); i++)
+				lengths[i] = weight[used[i]];
+		}
+		minimumRedundancy(lengths);
+
+		//the lightest symbol has the longest code
+		unsigned long long longest = lengths[0];
+		for (size_t i = 0; i < used.size(); i++)
+			length[used[i]] = (unsigned char)min(lengths[i], (unsigned long long)MAX_LENGTH);
+		if (longest <= MAX_LENGTH)
+			break;
+
+		//too deep, flatten the weights and try again
+		if (halved.empty())
+			halved = freq;
+		for (unsigned long long s = 0; s < AlphabetSize; s++)
+		{
+			if (halved[s] > 0)
+				halved[s] = halved[s] / 2 + 1;
+		}
+		weights = &halved;
+	}
+	assignCodes();
+	return true;
+}
+
+//turns weights sorted in increasing order into code lengths in the same array,
+//in linear time with no other memory (Moffat and Katajainen)
+template <class Symbol, unsigned long long AlphabetSize>
+void codec<Symbol, AlphabetSize>::minimumRedundancy(vector<unsigned long long>& A)
+{
+	size_t n = A.size();
+	if (n == 1)
+	{
+		A[0] = 1;
+		return;
+	}
+
+	//first pass, left to right, joining nodes and leaving each inner node
+	//holding the index of its parent once it has been joined
+	size_t root = 0;
+	size_t leaf = 2;
+	A[0] += A[1];
+	for (size_t next = 1; next < n - 1; next++)
+	{
+		//first of the pair
+		if (leaf >= n || A[root] < A[leaf])
+		{
+			A[next] = A[root];
+			A[root++] = next;
+		}
+		else
+			A[next] = A[leaf++];
+
+		//second of the pair
+		if (leaf >= n || (root < next && A[root] < A[leaf]))
+		{
+			A[next] += A[root];
+			A[root++] = next;
+		}
+		else
+			A[next] += A[leaf++];
+	}
+
+	//second pass, right to left, turning parent indexes into inner node depths
+	A[n - 2] = 0;
+	for (size_t next = n - 2; next-- > 0;)
+		A[next] = A[A[next]] + 1;
+
+	//third pass, right to left, handing out leaf depths level by level
+	long long avail = 1;
+	long long usedNodes = 0;
+	unsigned long long depth = 0;
+	long long innerNode = (long long)n - 2;
+	long long next = (long long)n - 1;
+	while (avail > 0)
+	{
+		while (innerNode >= 0 && A[innerNode] == depth)
+		{
+			usedNodes++;
+			innerNode--;
+		}
+		while (avail > usedNodes)
+		{
+			A[next--] = depth;
+			avail--;
+		}
+		avail = 2 * usedNodes;
+		depth++;
+		usedNodes = 0;
+	}
+}
+
+//assigns canonical codes, counting up through the symbols by length then by value
+template <class Symbol, unsigned long long AlphabetSize>
+void codec<Symbol, AlphabetSize>::assignCodes()
+{
+	for (int i = 0; i <= MAX_LENGTH; i++)
+		lengthCount[i] = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+		lengthCount[length[s]]++;
+	lengthCount[0] = 0;
+
+	//first code and position in sorted of each length
+	unsigned long long next = 0;
+	unsigned position = 0;
+	longestCode = 0;
+	for (int len = 1; len <= MAX_LENGTH; len++)
+	{
+		if (lengthCount[len] > 0)
+			longestCode = len;
+		next = (next + lengthCount[len - 1]) << 1;
+		first[len] = next;
+		start[len] = position;
+		position += lengthCount[len];
+	}
+
+	//hand out the codes
+	sorted.assign(position, 0);
+	vector<unsigned long long> nextCode(first, first + MAX_LENGTH + 1);
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		int len = length[s];
+		if (len > 0)
+		{
+			code[s] = nextCode[len];
+			sorted[start[len] + (code[s] - first[len])] = (Symbol)s;
+			nextCode[len]++;
+		}
+	}
+	buildTable();
+}
+
+//builds the multi-symbol decode table when the codes are short enough on average for an
+//entry to hold two or more, and clears it otherwise. Only the lengths are known when they
+//were stored, so the average weights each length by the share of the code space it takes
+template <class Symbol, unsigned long long AlphabetSize>
+void codec<Symbol, AlphabetSize>::buildTable()
+{
+	table.clear();
+	unsigned long long space = 0;
+	unsigned long long weighted = 0;
+	for (int len = 1; len <= longestCode; len++)
+	{
+		space += (unsigned long long)lengthCount[len] << (MAX_LENGTH - len);
+		weighted += ((unsigned long long)lengthCount[len] << (MAX_LENGTH - len)) * len;
+	}
+	if (space == 0 || 2 * weighted > TABLE_BITS * space)
+		return;
+
+	//each index, packed as code, holds the codes that end inside it
+	table.assign((size_t)1 << TABLE_BITS, tableEntry());
+	for (size_t index = 0; index < table.size(); index++)
+	{
+		const unsigned char bytes[2] = { (unsigned char)(index >> (TABLE_BITS - 8)),
+			(unsigned char)(index << (16 - TABLE_BITS)) };
+		tableEntry& entry = table[index];
+		size_t pos = 0;
+		while (entry.count < TABLE_SYMBOLS && decodeCode(bytes, TABLE_BITS, pos, entry.symbols[entry.count]))
+			entry.count++;
+		entry.bits = (unsigned char)pos;
+	}
+}
+
+//takes a code length for every symbol, 0 for no code, and assigns the canonical codes
+//build would have, returns false if the lengths cannot form a prefix code
+template <class Symbol, unsigned long long AlphabetSize>
+bool codec<Symbol, AlphabetSize>::setLengths(const unsigned char* lengths)
+{
+	//each code takes up 2^-length of the code space, counted here in units of 2^-MAX_LENGTH
+	unsigned long long space = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+	{
+		if (lengths[s] > MAX_LENGTH)
+			return false;
+		if (lengths[s] > 0)
+			space += 1ULL << (MAX_LENGTH - lengths[s]);
+		if (space > (1ULL << MAX_LENGTH))
+			return false;
+	}
+	length.assign(lengths, lengths + AlphabetSize);
+	assignCodes();
+	return true;
+}
+
+//returns the code length of a symbol, 0 if it has no code
+template <class Symbol, unsigned long long AlphabetSize>
+int codec<Symbol, AlphabetSize>::codeLength(Symbol symbol) const
+{
+	return length[symbol];
+}
+
+//packs the codes of an array of symbols onto the end of out,
+//returns the number of code bits or 0 if a symbol has no code
+template <class Symbol, unsigned long long AlphabetSize>
+template <class Allocator>
+size_t codec<Symbol, AlphabetSize>::encode(const Symbol* data, size_t size,
+	vector<unsigned char, Allocator>& out) const
+{
+	if (size == 0)
+		return 0;
+
+	//write straight into room for the longest possible code, then trim
+	size_t used = out.size();
+	size_t capacity = maxEncodedBytes(size);
+	out.resize(used + capacity);
+	size_t bits = encode(data, size, &out[used], capacity);
+	out.resize(used + (bits + 7) / 8);
+	return bits;
+}
+
+//packs the codes of an array of symbols into a buffer of the given capacity
+//without allocating, returns the number of code bits or 0 if a symbol has no
+//code or the buffer is too small
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::encode(const Symbol* data, size_t size, unsigned char* out,
+	size_t capacity) const
+{
+	size_t bits = 0;
+	size_t written = 0;
+	unsigned long long acc = 0;
+	int pending = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		int len = length[data[i]];
+		if (len == 0)
+			return 0;
+
+		//fewer than 8 bits are pending, so a code of up to MAX_LENGTH fits
+		acc = (acc << len) | code[data[i]];
+		pending += len;
+		bits += len;
+		while (pending >= 8)
+		{
+			if (written == capacity)
+				return 0;
+			pending -= 8;
+			out[written++] = (unsigned char)(acc >> pending);
+		}
+		acc &= (1ULL << pending) - 1;
+	}
+
+	//pad the last byte with 0s
+	if (pending > 0)
+	{
+		if (written == capacity)
+			return 0;
+		out[written++] = (unsigned char)(acc << (8 - pending));
+	}
+	return bits;
+}
+
+//returns the bits encode writes for the symbols counted
+template <class Symbol, unsigned long long AlphabetSize>
+unsigned long long codec<Symbol, AlphabetSize>::codeBits() const
+{
+	unsigned long long bits = 0;
+	for (unsigned long long s = 0; s < AlphabetSize; s++)
+		bits += freq[s] * length[s];
+	return bits;
+}
+
+//returns the most bytes encode can write for the given number of symbols
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::maxEncodedBytes(size_t size) const
+{
+	return (size * longestCode + 7) / 8;
+}
+
+//unpacks up to size symbols from the given number of code bits,
+//returns the number of symbols decoded
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::decode(const unsigned char* in, size_t bits, Symbol* out,
+	size_t size) const
+{
+	size_t decoded = 0;
+	size_t pos = 0;
+
+	//one lookup takes every whole code in the next TABLE_BITS bits, while the three bytes
+	//from the one holding pos are all code and out has room for a full entry
+	if (!table.empty())
+	{
+		while (pos + 16 < bits && decoded + TABLE_SYMBOLS <= size)
+		{
+			const unsigned char* at = in + (pos >> 3);
+			size_t window = ((size_t)at[0] << 16) | ((size_t)at[1] << 8) | at[2];
+			const tableEntry& entry = table[(window >> (24 - TABLE_BITS - (pos & 7))) & (table.size() - 1)];
+
+			//a code longer than the index is taken bit by bit
+			if (entry.count == 0)
+			{
+				if (!decodeCode(in, bits, pos, out[decoded]))
+					return decoded;
+				decoded++;
+				continue;
+			}
+			for (int k = 0; k < TABLE_SYMBOLS; k++)
+				out[decoded + k] = entry.symbols[k];
+			decoded += entry.count;
+			pos += entry.bits;
+		}
+	}
+
+	//the last bits, or all of them without a table
+	unsigned long long value = 0;
+	int len = 0;
+	for (size_t i = pos; i < bits && decoded < size; i++)
+	{
+		//add the next bit and check whether a code of this length matches
+		value = (value << 1) | ((in[i >> 3] >> (7 - (i & 7))) & 1);
+		len++;
+		if (value - first[len] < lengthCount[len])
+		{
+			out[decoded++] = sorted[start[len] + (value - first[len])];
+			value = 0;
+			len = 0;
+		}
+		else if (len == MAX_LENGTH)
+			break;
+	}
+	return decoded;
+}
+
+//unpacks one code starting at bit pos, adding a bit at a time until a code of that length
+//matches, and moves pos past it; returns false leaving pos alone if the bits end first or
+//no code matches
+template <class Symbol, unsigned long long AlphabetSize>
+bool codec<Symbol, AlphabetSize>::decodeCode(const unsigned char* in, size_t bits, size_t& pos,
+	Symbol& symbol) const
+{
+	unsigned long long value = 0;
+	int len = 0;
+	for (size_t at = pos; at < bits && len < MAX_LENGTH; at++)
+	{
+		value = (value << 1) | ((in[at >> 3] >> (7 - (at & 7))) & 1);
+		len++;
+		if (value - first[len] < lengthCount[len])
+		{
+			symbol = sorted[start[len] + (value - first[len])];
+			pos = at + 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+//steps over whole codes from bit pos until pos reaches last, returns the number of symbols
+//stepped over; pos ends past last when last falls inside a code, and short of it when the
+//code is damaged or ends first
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::skip(const unsigned char* in, size_t bits, size_t& pos,
+	size_t last) const
+{
+	size_t skipped = 0;
+	Symbol symbol;
+
+	//whole table entries while one ends short of last
+	if (!table.empty())
+	{
+		while (pos + 16 < bits && pos + TABLE_BITS <= last)
+		{
+			const unsigned char* at = in + (pos >> 3);
+			size_t window = ((size_t)at[0] << 16) | ((size_t)at[1] << 8) | at[2];
+			const tableEntry& entry = table[(window >> (24 - TABLE_BITS - (pos & 7))) & (table.size() - 1)];
+			if (entry.count == 0)
+			{
+				if (!decodeCode(in, bits, pos, symbol))
+					return skipped;
+				skipped++;
+				continue;
+			}
+			skipped += entry.count;
+			pos += entry.bits;
+		}
+	}
+	while (pos < last && decodeCode(in, bits, pos, symbol))
+		skipped++;
+	return skipped;
+}
+
+//codes count messages that share this codec into callers' buffers, stores each
+//message's code bits (0 on failure) in bits and returns the number coded
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::encodeBatch(const Symbol* const* in, const size_t* sizes,
+	size_t count, unsigned char* const* out, const size_t* capacity, size_t* bits) const
+{
+	const unsigned char* lengths = length.data();
+	const unsigned long long* codes = code.data();
+	size_t coded = 0;
+	for (size_t m = 0; m < count; m++)
+	{
+		bits[m] = 0;
+		if (sizes[m] == 0)
+		{
+			coded++;
+			continue;
+		}
+
+		//a buffer without BATCH_SLACK spare bytes goes through encode, which checks each byte
+		if (capacity[m] < maxEncodedBytes(sizes[m]) + BATCH_SLACK)
+		{
+			coded += (encodeBits(in[m], sizes[m], out[m], capacity[m], bits[m]) ? 1 : 0);
+			continue;
+		}
+
+		//local copies of the pointers, which a byte store could otherwise change
+		const Symbol* data = in[m];
+		unsigned char* buffer = out[m];
+		unsigned long long acc = 0;
+		int pending = 0;
+		size_t written = 0;
+		size_t total = 0;
+		int missing = 0;
+		for (size_t i = 0, size = sizes[m]; i < size; i++)
+			missing |= batchPut(data[i], lengths, codes, acc, pending, total, buffer, written);
+		if (pending > 0)
+			buffer[written] = (unsigned char)(acc << (8 - pending));
+		bits[m] = total;
+
+		//an uncoded symbol is rare, so the message is redone by encode, which fails it
+		if (missing)
+			coded += (encodeBits(data, sizes[m], buffer, capacity[m], bits[m]) ? 1 : 0);
+		else
+			coded++;
+	}
+	return coded;
+}
+
+//decodes count messages that share this codec into callers' buffers, stores the
+//number of symbols decoded from each in decoded and returns the number decoded in full
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::decodeBatch(const unsigned char* const* in, const size_t* bits,
+	size_t count, Symbol* const* out, const size_t* sizes, size_t* decoded) const
+{
+	size_t complete = 0;
+	for (size_t m = 0; m < count; m++)
+	{
+		decoded[m] = (sizes[m] == 0) ? 0 : decode(in[m], bits[m], out[m], sizes[m]);
+		if (decoded[m] == sizes[m])
+			complete++;
+	}
+	return complete;
+}
+
+//codes the array as streams parts of (size + streams - 1) / streams symbols, the last part
+//taking what is left, packing each part's code onto the end of out from a new byte and
+//storing its code bits in bits; returns the code bits of every part together, or 0 if a
+//symbol has no code
+template <class Symbol, unsigned long long AlphabetSize>
+template <class Allocator>
+size_t codec<Symbol, AlphabetSize>::encodeStreams(const Symbol* data, size_t size, int streams,
+	vector<unsigned char, Allocator>& out, size_t* bits) const
+{
+	if (size == 0 || streams < 1 || streams > MAX_STREAMS)
+		return 0;
+	size_t part = (size + streams - 1) / streams;
+	size_t total = 0;
+	for (int k = 0; k < streams; k++)
+	{
+		size_t first = min(size, k * part);
+		size_t count = min(size - first, part);
+		bits[k] = (count == 0) ? 0 : encode(data + first, count, out);
+		if (bits[k] == 0 && count > 0)
+			return 0;
+		total += bits[k];
+	}
+	return total;
+}
+
+//decodes code written by encodeStreams, the streams one after another from in and each
+//bits[k] long, into the parts of out. A single stream's next code cannot be found until the
+//one before it is, so each turn takes one lookup from every stream and the lookups do not
+//wait on each other. Returns the symbols decoded from all the streams, which is size only
+//when each decoded in full
+template <class Symbol, unsigned long long AlphabetSize>
+size_t codec<Symbol, AlphabetSize>::decodeStreams(const unsigned char* in, const size_t* bits,
+	int streams, Symbol* out, size_t size) const
+{
+	if (size == 0 || streams < 1 || streams > MAX_STREAMS)
+		return 0;
+
+	//each stream's bit position and end in in, and its place and end in out
+	size_t pos[MAX_STREAMS];
+	size_t end[MAX_STREAMS];
+	size_t next[MAX_STREAMS];
+	size_t last[MAX_STREAMS];
+	size_t part = (size + streams - 1) / streams;
+	size_t offset = 0;
+	for (int k = 0; k < streams; k++)
+	{
+		pos[k] = offset;
+		end[k] = offset + bits[k];
+		offset += (bits[k] + 7) / 8 * 8;
+		next[k] = min(size, k * part);
+		last[k] = min(size, next[k] + part);
+	}
+
+	//without the table there are no lookups to overlap, so each stream is decoded whole
+	if (table.empty())
+	{
+		size_t decoded = 0;
+		for (int k = 0; k < streams; k++)
+			decoded += decode(in + pos[k] / 8, bits[k], out + next[k], last[k] - next[k]);
+		return decoded;
+	}
+
+	//turns while every stream has a whole entry left, as in decode
+	bool room = true;
+	for (int k = 0; k < streams; k++)
+		room = room && pos[k] + 16 < end[k] && next[k] + TABLE_SYMBOLS <= last[k];
+	while (room)
+	{
+		for (int k = 0; k < streams; k++)
+		{
+			const unsigned char* at = in + (pos[k] >> 3);
+			size_t window = ((size_t)at[0] << 16) | ((size_t)at[1] << 8) | at[2];
+			const tableEntry& entry = table[(window >> (24 - TABLE_BITS - (pos[k] & 7))) & (table.size() - 1)];
+
+			//a code longer than the index is taken bit by bit, and a damaged one ends the turns
+			if (entry.count == 0)
+			{
+				if (decodeCode(in, end[k], pos[k], out[next[k]]))
+					next[k]++;
+				else
+					room = false;
+				continue;
+			}
+			for (int s = 0; s < TABLE_SYMBOLS; s++)
+				out[next[k] + s] = entry.symbols[s];
+			next[k] += entry.count;
+			pos[k] += entry.bits;
+		}
+		for (int k = 0; k < streams; k++)
+			room = room && pos[k] + 16 < end[k] && next[k] + TABLE_SYMBOLS <= last[k];
+	}
+
+	//the rest a code at a time, still a turn from each stream
+	size_t decoded = 0;
+	bool going = true;
+	while (going)
+	{
+		going = false;
+		for (int k = 0; k < streams; k++)
+		{
+			if (next[k] < last[k] && decodeCode(in, end[k], pos[k], out[next[k]]))
+			{
+				next[k]++;
+				going = true;
+			}
+		}
+	}
+	for (int k = 0; k < streams; k++)
+		decoded += next[k] - min(size, k * part);
+	return decoded;
+}
+
+//adds one symbol's code to a batch message and writes all its whole bytes with one
+//8 byte store, which is why batch buffers need BATCH_SLACK spare bytes, returns
+//1 if the symbol has no code
+template <class Symbol, unsigned long long AlphabetSize>
+inline int codec<Symbol, AlphabetSize>::batchPut(Symbol s, const unsigned char* lengths,
+	const unsigned long long* codes, unsigned long long& acc, int& pending, size_t& total,
+	unsigned char* out, size_t& written)
+{
+	//fewer than 8 bits are pending, so a code of up to MAX_LENGTH fits
+	int len = lengths[s];
+	acc = (acc << len) | codes[s];
+	pending += len;
+	total += len;
+
+	//line the pending bits up at the top of a word and store it whole
+	unsigned long long top = (acc << (63 - pending)) << 1;
+	unsigned char* at = out + written;
+	at[0] = (unsigned char)(top >> 56);
+	at[1] = (unsigned char)(top >> 48);
+	at[2] = (unsigned char)(top >> 40);
+	at[3] = (unsigned char)(top >> 32);
+	at[4] = (unsigned char)(top >> 24);
+	at[5] = (unsigned char)(top >> 16);
+	at[6] = (unsigned char)(top >> 8);
+	at[7] = (unsigned char)top;
+	written += pending >> 3;
+	pending &= 7;
+	return len == 0;
+}
+
+//codes one message of a batch with encode, storing its code bits in bits,
+//returns false if it could not be coded
+template <class Symbol, unsigned long long AlphabetSize>
+bool codec<Symbol, AlphabetSize>::encodeBits(const Symbol* data, size_t size, unsigned char* out,
+	size_t capacity, size_t& bits) const
+{
+	bits = encode(data, size, out, capacity);
+	return bits > 0;
+}
+
+#endif // !CODEC_H
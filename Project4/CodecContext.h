@@ -0,0 +1,192 @@
+/**************************************************************************************************
+*
+*   File name :			CodecContext.h
+*
+*   Header file for the encoderContext and decoderContext class templates, which code many
+*	small messages with one built codec. Each context keeps its buffer between calls and only
+*	grows it when a message is larger than any before, so once it has seen its largest message
+*	no call allocates. reset() empties a context without giving its memory back. A context
+*	given a MemoryAccount allocates its buffer through it, so a caller can budget a context
+*	as it budgets the codec's tables.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		encoderContext<Symbol, AlphabetSize>
+*
+*	Private data members:
+*		const codec* model			the built codec whose tables are used
+*		accountedVector buffer		the packed code of the last message
+*		size_t bits					the code bits of the last message
+*
+*	Public member functions:
+*		encoderContext		constructor for a context with room for messages of a given size
+*		void reset			forgets the last message, keeping the buffer
+*		size_t encode		codes a message into the context's buffer or a caller's buffer
+*		data				the packed code of the last message
+*		size				the bytes of packed code of the last message
+*
+*	Class Name:		decoderContext<Symbol, AlphabetSize>
+*
+*	Private data members:
+*		const codec* model			the built codec whose tables are used
+*		accountedVector buffer		the symbols of the last message
+*		size_t decoded				the number of symbols in the last message
+*
+*	Public member functions:
+*		decoderContext		constructor for a context with room for messages of a given size
+*		void reset			forgets the last message, keeping the buffer
+*		size_t decode		decodes a message into the context's buffer or a caller's buffer
+*		data				the symbols of the last message
+*		size				the number of symbols in the last message
+*
+****************************************************************************************************/
+#ifndef CODECCONTEXT_H
+#define CODECCONTEXT_H
+#include "Codec.h"
+
+//encoderContext class template coding messages with one codec
+template <class Symbol, unsigned long long AlphabetSize>
+class encoderContext
+{
+public:
+	encoderContext(const codec<Symbol, AlphabetSize>& model, size_t maxSymbols,
+		MemoryAccount* account = NULL);
+	void reset();
+	size_t encode(const Symbol* in, size_t size);
+	size_t encode(const Symbol* in, size_t size, unsigned char* out, size_t capacity) const;
+	const unsigned char* data() const;
+	size_t size() const;
+
+private:
+	const codec<Symbol, AlphabetSize>* model;
+	accountedVector<unsigned char> buffer;
+	size_t bits;
+};
+
+//decoderContext class template decoding messages with one codec
+template <class Symbol, unsigned long long AlphabetSize>
+class decoderContext
+{
+public:
+	decoderContext(const codec<Symbol, AlphabetSize>& model, size_t maxSymbols,
+		MemoryAccount* account = NULL);
+	void reset();
+	size_t decode(const unsigned char* in, size_t bits, size_t size);
+	size_t decode(const unsigned char* in, size_t bits, Symbol* out, size_t size) const;
+	const Symbol* data() const;
+	size_t size() const;
+
+private:
+	const codec<Symbol, AlphabetSize>* model;
+	accountedVector<Symbol> buffer;
+	size_t decoded;
+};
+
+//constructor, making room for the code of the largest expected message,
+//allocated through account, or with new when it is NULL
+template <class Symbol, unsigned long long AlphabetSize>
+encoderContext<Symbol, AlphabetSize>::encoderContext(const codec<Symbol, AlphabetSize>& model,
+	size_t maxSymbols, MemoryAccount* account)
+	: buffer(accountedAllocator<unsigned char>(account))
+{
+	this->model = &model;
+	buffer.resize(model.maxEncodedBytes(maxSymbols));
+	bits = 0;
+}
+
+//forgets the last message, keeping the buffer
+template <class Symbol, unsigned long long AlphabetSize>
+void encoderContext<Symbol, AlphabetSize>::reset()
+{
+	bits = 0;
+}
+
+//codes a message into the context's buffer, growing it only for a larger message
+//than any before, returns the number of code bits
+template <class Symbol, unsigned long long AlphabetSize>
+size_t encoderContext<Symbol, AlphabetSize>::encode(const Symbol* in, size_t size)
+{
+	size_t needed = model->maxEncodedBytes(size);
+	if (needed > buffer.size())
+		buffer.resize(needed);
+	bits = (size == 0 || buffer.empty()) ? 0 : model->encode(in, size, buffer.data(), buffer.size());
+	return bits;
+}
+
+//codes a message into a caller's buffer, returns the number of code bits
+//or 0 if the buffer is too small
+template <class Symbol, unsigned long long AlphabetSize>
+size_t encoderContext<Symbol, AlphabetSize>::encode(const Symbol* in, size_t size,
+	unsigned char* out, size_t capacity) const
+{
+	return model->encode(in, size, out, capacity);
+}
+
+//returns the packed code of the last message
+template <class Symbol, unsigned long long AlphabetSize>
+const unsigned char* encoderContext<Symbol, AlphabetSize>::data() const
+{
+	return buffer.data();
+}
+
+//returns the bytes of packed code of the last message
+template <class Symbol, unsigned long long AlphabetSize>
+size_t encoderContext<Symbol, AlphabetSize>::size() const
+{
+	return (bits + 7) / 8;
+}
+
+//constructor, making room for the largest expected message,
+//allocated through account, or with new when it is NULL
+template <class Symbol, unsigned long long AlphabetSize>
+decoderContext<Symbol, AlphabetSize>::decoderContext(const codec<Symbol, AlphabetSize>& model,
+	size_t maxSymbols, MemoryAccount* account)
+	: buffer(accountedAllocator<Symbol>(account))
+{
+	this->model = &model;
+	buffer.resize(maxSymbols);
+	decoded = 0;
+}
+
+//forgets the last message, keeping the buffer
+template <class Symbol, unsigned long long AlphabetSize>
+void decoderContext<Symbol, AlphabetSize>::reset()
+{
+	decoded = 0;
+}
+
+//decodes up to size symbols into the context's buffer, growing it only for a larger
+//message than any before, returns the number of symbols decoded
+template <class Symbol, unsigned long long AlphabetSize>
+size_t decoderContext<Symbol, AlphabetSize>::decode(const unsigned char* in, size_t bits,
+	size_t size)
+{
+	if (size > buffer.size())
+		buffer.resize(size);
+	decoded = (size == 0) ? 0 : model->decode(in, bits, buffer.data(), size);
+	return decoded;
+}
+
+//decodes up to size symbols into a caller's buffer, returns the number decoded
+template <class Symbol, unsigned long long AlphabetSize>
+size_t decoderContext<Symbol, AlphabetSize>::decode(const unsigned char* in, size_t bits,
+	Symbol* out, size_t size) const
+{
+	return model->decode(in, bits, out, size);
+}
+
+//returns the symbols of the last message
+template <class Symbol, unsigned long long AlphabetSize>
+const Symbol* decoderContext<Symbol, AlphabetSize>::data() const
+{
+	return buffer.data();
+}
+
+//returns the number of symbols in the last message
+template <class Symbol, unsigned long long AlphabetSize>
+size_t decoderContext<Symbol, AlphabetSize>::size() const
+{
+	return decoded;
+}
+
+#endif // !CODECCONTEXT_H
@@ -0,0 +1,96 @@
+/**************************************************************************************************
+*
+*   File name :			FixedTable.h
+*
+*   Compile time construction of Huffman code tables for alphabets whose frequencies are known
+*	in advance. makeFixedTable computes the code lengths and canonical codes as a constexpr,
+*	so a table such as ENGLISH_TABLE is baked into the program rather than built from a file.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Structs:
+*		fixedTable					the code length and canonical code of each character
+*
+*	Functions:
+*		makeFixedTable				builds a fixedTable from an array of frequencies
+*
+****************************************************************************************************/
+#ifndef FIXEDTABLE_H
+#define FIXEDTABLE_H
+
+//fixedTable struct holding the code for each of N characters
+template <int N>
+struct fixedTable
+{
+	int length[N];
+	unsigned code[N];
+};
+
+//builds the code table for N characters from their frequencies
+template <int N>
+constexpr fixedTable<N> makeFixedTable(const int (&freq)[N])
+{
+	//the first N nodes are the characters, the rest are inner nodes
+	long long weight[2 * N] = {};
+	int parent[2 * N] = {};
+	bool merged[2 * N] = {};
+	for (int i = 0; i < N; i++)
+	{
+		//every character keeps a weight so it still gets a code
+		weight[i] = (freq[i] > 0) ? freq[i] : 1;
+		parent[i] = -1;
+	}
+
+	//join the two lightest unmerged nodes until only the root is left
+	for (int next = N; next < 2 * N - 1; next++)
+	{
+		int low[2] = { -1, -1 };
+		for (int pick = 0; pick < 2; pick++)
+		{
+			for (int i = 0; i < next; i++)
+			{
+				if (!merged[i] && (low[pick] == -1 || weight[i] < weight[low[pick]]))
+					low[pick] = i;
+			}
+			merged[low[pick]] = true;
+		}
+		weight[next] = weight[low[0]] + weight[low[1]];
+		parent[next] = -1;
+		parent[low[0]] = next;
+		parent[low[1]] = next;
+	}
+
+	//a character's code length is its depth below the root
+	fixedTable<N> table = {};
+	int maxLength = 0;
+	for (int i = 0; i < N; i++)
+	{
+		table.length[i] = 0;
+		for (int p = parent[i]; p != -1; p = parent[p])
+			table.length[i]++;
+		if (table.length[i] > maxLength)
+			maxLength = table.length[i];
+	}
+
+	//canonical codes, counting up through the characters by length then by order
+	unsigned code = 0;
+	for (int length = 1; length <= maxLength; length++)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			if (table.length[i] == length)
+				table.code[i] = code++;
+		}
+		code <<= 1;
+	}
+	return table;
+}
+
+//frequency of each letter from a to z in English text, per 100000 letters
+constexpr int ENGLISH_FREQ[26] = { 8167, 1492, 2782, 4253, 12702, 2228, 2015, 6094, 6966, 153,
+	772, 4025, 2406, 6749, 7507, 1929, 95, 5987, 6327, 9056, 2758, 978, 2360, 150, 1974, 74 };
+
+//code table for English text, built by the compiler
+constexpr fixedTable<26> ENGLISH_TABLE = makeFixedTable(ENGLISH_FREQ);
+
+#endif // !FIXEDTABLE_H
@@ -0,0 +1,218 @@
+/**************************************************************************************************
+*
+*   File name :			HuffLib.cpp
+*
+*	Implementation of the C interface as defined in HuffLib.h, over a byteCodec. No exception
+*	or message leaves a call; each failure becomes a huff_status. Every call that can allocate,
+*	including making the codec, whose members allocate their tables, catches whatever is
+*	thrown, since an exception crossing into C code ends the process.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#ifndef HUFFLIB_STATIC
+#define HUFFLIB_EXPORTS
+#endif
+#include "HuffLib.h"
+#include "Codec.h"
+using namespace std;
+
+//huff_codec struct holding a byte codec and whether it has a table
+struct huff_codec
+{
+	byteCodec model;
+	bool trained;
+};
+
+//returns the interface version
+int huff_version(void)
+{
+	return HUFF_VERSION;
+}
+
+//returns a description of a status
+const char* huff_status_text(huff_status status)
+{
+	switch (status)
+	{
+	case HUFF_OK:
+		return "done";
+	case HUFF_BAD_ARGUMENT:
+		return "a pointer was null or a size was impossible";
+	case HUFF_NOT_TRAINED:
+		return "the codec has no table yet";
+	case HUFF_EMPTY_SAMPLE:
+		return "there was nothing to train on";
+	case HUFF_UNCODED_BYTE:
+		return "the input has a byte the table has no code for";
+	case HUFF_BUFFER_TOO_SMALL:
+		return "the output buffer is smaller than needed";
+	case HUFF_DAMAGED_INPUT:
+		return "a table or code could not be read";
+	case HUFF_OUT_OF_MEMORY:
+		return "the codec could not allocate its tables";
+	case HUFF_ERROR_TABLE:
+		return "the table codes no bytes or its lengths overfill the code space";
+	default:
+		return "unknown status";
+	}
+}
+
+//makes an untrained codec, stored in codec
+huff_status huff_create(huff_codec** codec)
+{
+	if (codec == NULL)
+		return HUFF_BAD_ARGUMENT;
+	*codec = NULL;
+	try
+	{
+		*codec = new huff_codec;
+	}
+	catch (...)
+	{
+		return HUFF_OUT_OF_MEMORY;
+	}
+	(*codec)->trained = false;
+	return HUFF_OK;
+}
+
+//frees a codec, doing nothing for null
+void huff_destroy(huff_codec* codec)
+{
+	delete codec;
+}
+
+//builds a codec's table from the counts of sample bytes, replacing any table it had
+huff_status huff_train(huff_codec* codec, const unsigned char* sample, size_t size)
+{
+	if (codec == NULL || (sample == NULL && size > 0))
+		return HUFF_BAD_ARGUMENT;
+	try
+	{
+		codec->model.reset();
+		codec->trained = false;
+		codec->model.count(sample, size);
+		if (!codec->model.build())
+			return HUFF_EMPTY_SAMPLE;
+	}
+	catch (...)
+	{
+		return HUFF_OUT_OF_MEMORY;
+	}
+	codec->trained = true;
+	return HUFF_OK;
+}
+
+//writes a codec's table, the code length of each byte value, into a caller's buffer
+huff_status huff_save_table(const huff_codec* codec, unsigned char* table, size_t capacity)
+{
+	if (codec == NULL || table == NULL)
+		return HUFF_BAD_ARGUMENT;
+	if (!codec->trained)
+		return HUFF_NOT_TRAINED;
+	if (capacity < HUFF_TABLE_BYTES)
+		return HUFF_BUFFER_TOO_SMALL;
+	for (int s = 0; s < HUFF_TABLE_BYTES; s++)
+		table[s] = (unsigned char)codec->model.codeLength((uint8_t)s);
+	return HUFF_OK;
+}
+
+//builds a codec's table from one written by huff_save_table, which always codes a byte
+huff_status huff_load_table(huff_codec* codec, const unsigned char* table, size_t size)
+{
+	if (codec == NULL || table == NULL)
+		return HUFF_BAD_ARGUMENT;
+	if (size < HUFF_TABLE_BYTES)
+		return HUFF_DAMAGED_INPUT;
+	int coded = 0;
+	for (int s = 0; s < HUFF_TABLE_BYTES; s++)
+		coded += (table[s] > 0) ? 1 : 0;
+	if (coded == 0)
+	{
+		codec->trained = false;
+		return HUFF_ERROR_TABLE;
+	}
+	try
+	{
+		codec->trained = codec->model.setLengths(table);
+	}
+	catch (...)
+	{
+		codec->trained = false;
+		return HUFF_OUT_OF_MEMORY;
+	}
+	return codec->trained ? HUFF_OK : HUFF_ERROR_TABLE;
+}
+
+//stores in bound the most bytes huff_encode can write for size input bytes
+huff_status huff_encode_bound(const huff_codec* codec, size_t size, size_t* bound)
+{
+	if (codec == NULL || bound == NULL)
+		return HUFF_BAD_ARGUMENT;
+	if (!codec->trained)
+		return HUFF_NOT_TRAINED;
+	*bound = codec->model.maxEncodedBytes(size);
+	return HUFF_OK;
+}
+
+//codes size bytes into a caller's buffer, storing the number of code bits in bits
+huff_status huff_encode(const huff_codec* codec, const unsigned char* in, size_t size,
+	unsigned char* out, size_t capacity, size_t* bits)
+{
+	if (codec == NULL || bits == NULL || ((in == NULL || out == NULL) && size > 0))
+		return HUFF_BAD_ARGUMENT;
+	if (!codec->trained)
+		return HUFF_NOT_TRAINED;
+	*bits = 0;
+
+	//checked first, since codec::encode only returns 0 and the caller is told which failure it was
+	for (size_t i = 0; i < size; i++)
+	{
+		if (codec->model.codeLength(in[i]) == 0)
+			return HUFF_UNCODED_BYTE;
+	}
+	if (size == 0)
+		return HUFF_OK;
+	if (capacity < codec->model.maxEncodedBytes(size))
+	{
+		//the bound assumes every byte takes the longest code, so the code may still fit
+		size_t needed = 0;
+		for (size_t i = 0; i < size; i++)
+			needed += codec->model.codeLength(in[i]);
+		if (capacity < (needed + 7) / 8)
+			return HUFF_BUFFER_TOO_SMALL;
+	}
+	try
+	{
+		*bits = codec->model.encode(in, size, out, capacity);
+	}
+	catch (...)
+	{
+		*bits = 0;
+		return HUFF_OUT_OF_MEMORY;
+	}
+	return (*bits > 0) ? HUFF_OK : HUFF_BUFFER_TOO_SMALL;
+}
+
+//decodes size bytes from the given number of code bits into a caller's buffer
+huff_status huff_decode(const huff_codec* codec, const unsigned char* in, size_t bits,
+	unsigned char* out, size_t size)
+{
+	if (codec == NULL || ((in == NULL && bits > 0) || (out == NULL && size > 0)))
+		return HUFF_BAD_ARGUMENT;
+	if (!codec->trained)
+		return HUFF_NOT_TRAINED;
+	if (size == 0)
+		return HUFF_OK;
+	if (in == NULL)
+		return HUFF_DAMAGED_INPUT;
+	try
+	{
+		if (codec->model.decode(in, bits, out, size) != size)
+			return HUFF_DAMAGED_INPUT;
+	}
+	catch (...)
+	{
+		return HUFF_OUT_OF_MEMORY;
+	}
+	return HUFF_OK;
+}
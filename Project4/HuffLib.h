@@ -0,0 +1,91 @@
+/**************************************************************************************************
+*
+*   File name :			HuffLib.h
+*
+*   Header file for the C interface to the byte codec, implemented in HuffLib.cpp and built as
+*	a shared library by HuffLib.vcxproj and as a static library by HuffLibStatic.vcxproj, so
+*	programs in other languages can code in process through a foreign function interface.
+*
+*	Every call works on buffers the caller owns: the library never allocates a buffer it hands
+*	back and never copies the input, and huff_encode_bound says how large an output buffer has
+*	to be. Every call returns a huff_status rather than printing, and huff_status_text names it.
+*	A trained or loaded huff_codec is only read by huff_encode and huff_decode, so any number
+*	of threads may code with one at once.
+*
+*	Define HUFFLIB_STATIC when linking the static library.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Types:
+*		huff_codec					a byte codec, opaque to the caller
+*		huff_status					the result of a call
+*
+*	Functions:
+*		huff_version				the version of the interface
+*		huff_status_text			a description of a status
+*		huff_create					makes an untrained codec
+*		huff_destroy				frees a codec
+*		huff_train					builds a codec's table from sample bytes
+*		huff_save_table				writes a codec's table, HUFF_TABLE_BYTES long
+*		huff_load_table				builds a codec's table from one written by huff_save_table
+*		huff_encode_bound			the most bytes huff_encode can write for an input size
+*		huff_encode					codes bytes into a caller's buffer
+*		huff_decode					decodes bytes into a caller's buffer
+*
+****************************************************************************************************/
+#ifndef HUFFLIB_H
+#define HUFFLIB_H
+#include <stddef.h>
+
+#if defined(HUFFLIB_STATIC)
+#define HUFF_API
+#elif defined(_WIN32) && defined(HUFFLIB_EXPORTS)
+#define HUFF_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define HUFF_API __declspec(dllimport)
+#else
+#define HUFF_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the interface version, raised when a call changes */
+#define HUFF_VERSION 1
+
+/* bytes in a saved table, one code length per byte value */
+#define HUFF_TABLE_BYTES 256
+
+typedef struct huff_codec huff_codec;
+
+typedef enum huff_status
+{
+	HUFF_OK = 0,
+	HUFF_BAD_ARGUMENT,			/* a pointer was null or a size was impossible */
+	HUFF_NOT_TRAINED,			/* the codec has no table yet */
+	HUFF_EMPTY_SAMPLE,			/* there was nothing to train on */
+	HUFF_UNCODED_BYTE,			/* the input has a byte the table has no code for */
+	HUFF_BUFFER_TOO_SMALL,		/* the output buffer is smaller than needed */
+	HUFF_DAMAGED_INPUT,			/* a table or code could not be read */
+	HUFF_OUT_OF_MEMORY,			/* the codec could not allocate its tables */
+	HUFF_ERROR_TABLE			/* a table codes no bytes or its lengths overfill the code space */
+} huff_status;
+
+HUFF_API int huff_version(void);
+HUFF_API const char* huff_status_text(huff_status status);
+HUFF_API huff_status huff_create(huff_codec** codec);
+HUFF_API void huff_destroy(huff_codec* codec);
+HUFF_API huff_status huff_train(huff_codec* codec, const unsigned char* sample, size_t size);
+HUFF_API huff_status huff_save_table(const huff_codec* codec, unsigned char* table, size_t capacity);
+HUFF_API huff_status huff_load_table(huff_codec* codec, const unsigned char* table, size_t size);
+HUFF_API huff_status huff_encode_bound(const huff_codec* codec, size_t size, size_t* bound);
+HUFF_API huff_status huff_encode(const huff_codec* codec, const unsigned char* in, size_t size,
+	unsigned char* out, size_t capacity, size_t* bits);
+HUFF_API huff_status huff_decode(const huff_codec* codec, const unsigned char* in, size_t bits,
+	unsigned char* out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !HUFFLIB_H
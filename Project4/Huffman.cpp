@@ -12,11 +12,30 @@
 *   Date Last Revised:	5/15/19
 ****************************************************************************************************/
 #include "Huffman.h"
+#include "FixedTable.h"
+#include "BitText.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cctype>
+#include <climits>
+#include <queue>
+#include <functional>
+#include <map>
 using namespace std;
 
+//bytes read from the input file per block, and the fewest read under a memory budget
+const int READ_BLOCK = 65536;
+const int MIN_BLOCK = 256;
+
+//first character of an encoded file holding the characters themselves
+const char STORED_FLAG = '#';
+
+//bits per character of a stored packed file, and the fraction of those bits
+//packed code has to save before it is kept instead of storing
+const int STORED_BITS = 8;
+const double MIN_GAIN = 0.0625;
+
 /*******************************************************************************************
 *	Function Name:			Huffman				the constructor
 *	Purpose:				This constructor creates a Huffman object and initialized a
@@ -25,8 +44,14 @@ using namespace std;
 *	Return value:			none
 ********************************************************************************************/
 Huffman::Huffman()
+	: memory("Huffman"), inString(accountedAllocator<char>(&memory)),
+	fullCode(accountedAllocator<char>(&memory))
 {
 	populated = false;
+	textStreamed = false;
+	textLength = 0;
+	checkpointInterval = 0;
+	sampleStride = 1;
 }
 
 /*******************************************************************************************
@@ -41,7 +66,7 @@ void Huffman::makeTree()
 	huffNode newNode;	//node to be added
 	huffNode curr;		//current node
 	//constructs inner nodes
-	for (int i = 0; i < 25; i++)
+	for (int i = 0; i < ALPHABET_SIZE - 1; i++)
 	{
 		newNode.name = "T";
 		newNode.name += to_string(i);	
@@ -54,8 +79,9 @@ void Huffman::makeTree()
 		pos += 2;
 
 		//add inner node to vector and resort with new node added
+		//stable so the new node lands after the pair it was built from
 		nodes.push_back(newNode);
-		sort(nodes.begin(), nodes.end());
+		stable_sort(nodes.begin(), nodes.end());
 	}
 	pos = 0;
 	
@@ -92,54 +118,446 @@ void Huffman::makeTree()
 				curr = *curr.parent;
 				nodes[i].code.insert(0, curr.code);
 			}
+
+			//index the finished code by character for encoding
+			codeTable[nodes[i].name[0] - FIRST_CHAR] = nodes[i].code;
 		}
 	}
 }
 
+/*******************************************************************************************
+*	Function Name:			buildTree
+*	Purpose:				Constructs the Huffman tree from the codes already in
+*							codeTable, one inner node for each prefix of a code
+*	Input Parameters:		vector<int> freq	the frequency of each character
+*	Return value:			none
+********************************************************************************************/
+void Huffman::buildTree(const vector<int>& freq)
+{
+	huffNode newNode;
+	newNode.left = NULL;
+	newNode.right = NULL;
+	newNode.parent = NULL;
+
+	//every proper prefix of a code is an inner node
+	map<string, int> inner;
+	for (int i = 0; i < ALPHABET_SIZE; i++)
+	{
+		for (unsigned j = 0; j < codeTable[i].size(); j++)
+			inner[codeTable[i].substr(0, j)] = 0;
+	}
+
+	//room for every node up front so the pointers stay valid
+	nodes.erase(nodes.begin(), nodes.end());
+	nodes.reserve(ALPHABET_SIZE + inner.size());
+
+	//characters first, then inner nodes longest prefix first so the root is last
+	for (int i = 0; i < ALPHABET_SIZE; i++)
+	{
+		newNode.name = (char)(FIRST_CHAR + i);
+		newNode.freq = freq[i];
+		newNode.code = codeTable[i];
+		nodes.push_back(newNode);
+	}
+	vector<string> prefixes;
+	for (map<string, int>::iterator it = inner.begin(); it != inner.end(); it++)
+		prefixes.push_back(it->first);
+	stable_sort(prefixes.begin(), prefixes.end(),
+		[](const string& a, const string& b) { return a.size() > b.size(); });
+	for (unsigned i = 0; i < prefixes.size(); i++)
+	{
+		//inner nodes only keep the bit that leads to them, as in makeTree
+		newNode.name = "T" + to_string(i);
+		newNode.freq = 0;
+		newNode.code = prefixes[i].empty() ? "" : prefixes[i].substr(prefixes[i].size() - 1);
+		inner[prefixes[i]] = nodes.size();
+		nodes.push_back(newNode);
+	}
+
+	//point each node and its parent at each other, summing frequencies upward
+	for (unsigned i = 0; i < nodes.size(); i++)
+	{
+		string path = (i < ALPHABET_SIZE) ? codeTable[i] : prefixes[i - ALPHABET_SIZE];
+		if (path.empty())
+			continue;
+		huffNode* parent = &nodes[inner[path.substr(0, path.size() - 1)]];
+		nodes[i].parent = parent;
+		if (path[path.size() - 1] == '0')
+			parent->left = &nodes[i];
+		else
+			parent->right = &nodes[i];
+		if (i < ALPHABET_SIZE)
+		{
+			for (huffNode* up = parent; up != NULL; up = up->parent)
+				up->freq += nodes[i].freq;
+		}
+	}
+}
+
+/*******************************************************************************************
+*	Function Name:			useFixedTable
+*	Purpose:				Loads the English code table the compiler built from known
+*							letter frequencies, so no file has to be read or counted
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Huffman::useFixedTable()
+{
+	vector<int> freq(ENGLISH_FREQ, ENGLISH_FREQ + ALPHABET_SIZE);
+	for (int i = 0; i < ALPHABET_SIZE; i++)
+	{
+		codeTable[i] = "";
+		for (int bit = ENGLISH_TABLE.length[i] - 1; bit >= 0; bit--)
+			codeTable[i] += ((ENGLISH_TABLE.code[i] >> bit) & 1) ? '1' : '0';
+	}
+	buildTree(freq);
+	populated = true;
+	cout << "Using the built-in English code table" << endl << endl;
+}
+
 /*******************************************************************************************
 *	Function Name:			encode
 *	Purpose:				Encodes an input string as a string of 0s and 1s according
-*							to the constructed Huffman tree
+*							to the constructed Huffman tree. When the code does not fit the
+*							memory budget it is written to the file a block at a time, as
+*							it is coded, instead of being printed
 *	Input Parameters:		none
 *	Return value:			none
 ********************************************************************************************/
 void Huffman::encode()
 {
-	//reading the file and constructing the tree
-	readFile();
-	countChars();
-	makeTree();
+	//reading the file, or only finding it when it does not fit the memory budget
+	if (!readFile())
+		return;
+	vector<int> freq;
+	{
+		profileScope phase(profiler, PHASE_HISTOGRAM, 0);
+		memoryPhase memPhase(memory, PHASE_HISTOGRAM);
+		freq = histogram();
+		phase.bytes = textLength;
+	}
 
-	//get the code for each character in the input string
-	for (unsigned i = 0; i < inString.size(); i++)
+	//keep the current tree when coding with it costs no more than a new tree
+	//would; encoded files hold no table, so only the code bits are compared
+	bool reuse = false;
+	size_t freshBits = optimalBits(freq) * sampleStride;
+	size_t reuseBits = freshBits;
+	if (!nodes.empty())
 	{
-		for (unsigned j = 0; j < nodes.size(); j++)
-		{
-			if (inString.substr(i, 1) == nodes[j].name)
-				fullCode += nodes[j].code;
-		}
+		reuseBits = tableBits(freq) * sampleStride;
+		reuse = (reuseBits <= freshBits);
+		cout << "Current table: " << reuseBits << " bits, new table: " << freshBits << " bits" << endl;
 	}
 
-	cout << "The encoded message:" << endl;
-	cout << fullCode << endl;
+	//store the characters themselves, leaving the tree alone, when the counts say the
+	//chosen table's code would save too little over them, before any code is written
+	if (isIncompressible(reuse ? reuseBits : freshBits, textLength))
+	{
+		memoryPhase memPhase(memory, PHASE_ENCODE);
+		string fileName;
+		cout << "The input does not compress, storing it as is" << endl;
+		cout << "Enter the name of the file to save the code to: ";
+		cin >> fileName;
+		ofstream outFile;
+		outFile.open(fileName);
+		outFile << STORED_FLAG;
+		forTextBlocks([&](const char* text, size_t size) { outFile.write(text, size); });
+		outFile << '*';
+		outFile.close();
 
-	//save the code to a file
+		//stored characters are found without an index, so an old one would mislead
+		remove((fileName + ".idx").c_str());
+		cout << "\n\nFile stored in " << fileName << endl;
+		return;
+	}
+
+	//constructing the tree
+	if (reuse)
+		cout << "Reusing the current code table" << endl;
+	else
+	{
+		profileScope phase(profiler, PHASE_BUILD, textLength);
+		memoryPhase memPhase(memory, PHASE_BUILD);
+		nodes.erase(nodes.begin(), nodes.end());
+		countChars(freq);
+		makeTree();
+	}
+
+	//size the output once from the frequencies and code lengths, scaled back up when
+	//the frequencies came from a sample, or only a block of it when it does not fit
+	memoryPhase memPhase(memory, PHASE_ENCODE);
+	size_t codeSize = tableBits(freq) * sampleStride + 1;
+	bool codeStreamed = (textStreamed && sampleStride == 1)
+		|| !memory.fits((sampleStride > 1) ? 2 * codeSize : codeSize);
 	string fileName;
-	cout << "Enter the name of the file to save the code to: ";
-	cin >> fileName;
 	ofstream outFile;
-	outFile.open(fileName);
+	if (codeStreamed)
+	{
+		cout << "The code does not fit the memory budget, writing it straight to the file" << endl;
+		cout << "Enter the name of the file to save the code to: ";
+		cin >> fileName;
+		outFile.open(fileName);
+		codeSize = blockSize() + 2 * ALPHABET_SIZE;
+	}
+	fullCode.reserve(codeSize);
+
+	//get the code for each character in the input string with one table lookup,
+	//recording a checkpoint at the first character boundary past every interval
+	vector<checkpoint> checkpoints;
+	size_t nextCheckpoint = 0;
+	size_t codeBits = 0;
+	unsigned symbol = 0;
+	vector<int> exactFreq(ALPHABET_SIZE, 0);
+	{
+		profileScope phase(profiler, PHASE_ENCODE, textLength);
+		forTextBlocks([&](const char* text, size_t size)
+		{
+			for (size_t i = 0; i < size; i++, symbol++)
+			{
+				if (checkpointInterval > 0 && codeBits >= nextCheckpoint)
+				{
+					checkpoints.push_back({ symbol, codeBits });
+					nextCheckpoint = codeBits + checkpointInterval;
+				}
+				const string& code = codeTable[text[i] - FIRST_CHAR];
+				fullCode.append(code.data(), code.size());
+				codeBits += code.size();
+				exactFreq[text[i] - FIRST_CHAR]++;
+				if (codeStreamed && fullCode.size() >= blockSize())
+				{
+					outFile << fullCode;
+					fullCode.clear();
+				}
+			}
+		});
+	}
+
+	//a sampled length was only an estimate
+	textLength = symbol;
+
+	//compare a sampled table against the best table for the exact counts
+	if (sampleStride > 1)
+	{
+		size_t exactBits = optimalBits(exactFreq);
+		cout << "Sampled table: " << codeBits << " bits, exact table: " << exactBits << " bits";
+		if (exactBits > 0)
+			cout << " (" << 100.0 * ((double)codeBits - exactBits) / exactBits << "% lost)";
+		cout << endl;
+	}
+
+	//save the code to a file
+	if (!codeStreamed)
+	{
+		cout << "The encoded message:" << endl;
+		cout << fullCode << endl;
+		cout << "Enter the name of the file to save the code to: ";
+		cin >> fileName;
+		outFile.open(fileName);
+	}
 
 	//append terminating character
 	outFile << fullCode << '*';
 	outFile.close();
 	cout << "\n\nFile encoded in " << fileName << endl;
+	if (codeStreamed)
+	{
+		fullCode.clear();
+		fullCode.shrink_to_fit();
+	}
+
+	//save the checkpoint index next to the code
+	if (!checkpoints.empty())
+	{
+		outFile.open(fileName + ".idx");
+		for (unsigned i = 0; i < checkpoints.size(); i++)
+			outFile << checkpoints[i].symbol << " " << checkpoints[i].bit << endl;
+		outFile.close();
+		cout << checkpoints.size() << " checkpoints written to " << fileName << ".idx" << endl;
+	}
+}
+
+/*******************************************************************************************
+*	Function Name:			setCheckpoints
+*	Purpose:				Sets how many code bits encode() writes between checkpoints,
+*							0 turns checkpoints off
+*	Input Parameters:		int interval		code bits between checkpoints
+*	Return value:			none
+********************************************************************************************/
+void Huffman::setCheckpoints(int interval)
+{
+	checkpointInterval = (interval > 0) ? interval : 0;
+}
+
+/*******************************************************************************************
+*	Function Name:			setSampleStride
+*	Purpose:				Sets how often encode() samples the input when counting, 1
+*							counts every block
+*	Input Parameters:		int stride			count one block of text in every stride
+*	Return value:			none
+********************************************************************************************/
+void Huffman::setSampleStride(int stride)
+{
+	sampleStride = (stride > 1) ? stride : 1;
+}
+
+/*******************************************************************************************
+*	Function Name:			optimalBits
+*	Purpose:				Finds the number of code bits the best Huffman table for a set
+*							of frequencies would use, by summing the merged weights
+*	Input Parameters:		vector<int> freq	the frequency of each character
+*	Return value:			size_t				the total code bits
+********************************************************************************************/
+size_t Huffman::optimalBits(const vector<int>& freq)
+{
+	priority_queue<size_t, vector<size_t>, greater<size_t> > weights;
+	for (unsigned i = 0; i < freq.size(); i++)
+	{
+		if (freq[i] > 0)
+			weights.push(freq[i]);
+	}
+
+	//a single character still takes one bit each
+	if (weights.size() == 1)
+		return weights.top();
+
+	size_t bits = 0;
+	while (weights.size() > 1)
+	{
+		size_t merged = weights.top();
+		weights.pop();
+		merged += weights.top();
+		weights.pop();
+		bits += merged;
+		weights.push(merged);
+	}
+	return bits;
+}
+
+/*******************************************************************************************
+*	Function Name:			isIncompressible
+*	Purpose:				Finds whether code saves less than MIN_GAIN over storing the
+*							characters it codes, a byte each as a packed file holds them.
+*							Code bits are compared as packed bits, since a text file's
+*							byte per bit is undone by converting it
+*	Input Parameters:		unsigned long long codeBits		the bits of code predicted
+*							unsigned long long characters	the characters they code
+*	Return value:			bool				true if the characters should be stored
+********************************************************************************************/
+bool Huffman::isIncompressible(unsigned long long codeBits, unsigned long long characters)
+{
+	return codeBits > STORED_BITS * characters * (1 - MIN_GAIN);
+}
+
+/*******************************************************************************************
+*	Function Name:			decodeRange
+*	Purpose:				Decodes part of an encoded file, starting from the nearest
+*							checkpoint in its index so earlier code is never read
+*	Input Parameters:		string fileName		the encoded file
+*							unsigned offset		first character to decode
+*							unsigned length		number of characters to decode
+*	Return value:			string				the decoded characters
+********************************************************************************************/
+string Huffman::decodeRange(const string& fileName, unsigned offset, unsigned length)
+{
+	string ans = "";
+	ifstream inFile;
+	inFile.open(fileName, ios::binary);
+	if (!inFile)
+	{
+		cout << "Error opening file " << fileName << endl;
+		return ans;
+	}
+
+	//a packed file's payload starts after its header and has a known size
+	char kind = '\0';
+	unsigned long long count = 0;
+	bool packed = readPackedHeader(inFile, kind, count);
+	streamoff base = packed ? PACKED_HEADER : 0;
+
+	//a stored file is read straight from the offset
+	if ((packed && kind == PACKED_STORED) || (!packed && inFile.peek() == STORED_FLAG))
+	{
+		char buffer[READ_BLOCK];
+		inFile.seekg(base + (streamoff)offset + (packed ? 0 : 1));
+		while (ans.size() < length)
+		{
+			inFile.read(buffer, min((size_t)READ_BLOCK, length - ans.size()));
+			if (inFile.gcount() == 0)
+				break;
+			ans.append(buffer, (size_t)inFile.gcount());
+		}
+		inFile.close();
+		return packed ? ans : ans.substr(0, ans.find('*'));
+	}
+	if (nodes.empty())
+	{
+		cout << "No tree has been constructed to decode with" << endl;
+		return ans;
+	}
+
+	//find the last checkpoint at or before the offset, a missing index starts at 0
+	checkpoint start = { 0, 0 };
+	checkpoint next;
+	ifstream idxFile;
+	idxFile.open(fileName + ".idx");
+	while (idxFile >> next.symbol >> next.bit && next.symbol <= offset)
+		start = next;
+	idxFile.close();
+
+	//jump straight to the checkpoint's bit, or the byte holding it in a packed file
+	size_t firstBit = 0;
+	unsigned long long bitsLeft = 0;
+	if (packed)
+	{
+		inFile.seekg(base + (streamoff)(start.bit / 8));
+		firstBit = start.bit % 8;
+		bitsLeft = (count > start.bit) ? count - start.bit : 0;
+	}
+	else
+		inFile.seekg(start.bit);
+	unsigned skip = offset - start.symbol;
+
+	const huffNode* root = &nodes[nodes.size() - 1];
+	const huffNode* curr = root;
+	if (length < READ_BLOCK)
+		ans.reserve(length);
+
+	//decode a block at a time until enough characters are out or the code ends
+	string block;
+	bool done = (length == 0);
+	while (!done && nextCodeBlock(inFile, packed, firstBit, bitsLeft, block))
+	{
+		for (size_t i = 0; i < block.size() && !done; i++)
+		{
+			if (block[i] == '*')
+				done = true;
+			else
+			{
+				curr = (block[i] == '0') ? curr->left : curr->right;
+				if (curr->left == NULL)
+				{
+					//characters before the offset are only stepped over
+					if (skip > 0)
+						skip--;
+					else
+					{
+						ans += curr->name[0];
+						done = (ans.size() == length);
+					}
+					curr = root;
+				}
+			}
+		}
+	}
+	inFile.close();
+	return ans;
 }
 
 /*******************************************************************************************
 *	Function Name:			decode
 *	Purpose:				Decodes an input string of 0s and 1s according to
-*							the constructed Huffman tree
+*							the constructed Huffman tree, a block at a time when the code
+*							does not fit the memory budget
 *	Input Parameters:		none
 *	Return value:			none
 ********************************************************************************************/
@@ -149,61 +567,461 @@ void Huffman::decode()
 	string fileName;
 	cout << "Enter the name of the file you would like to decode: ";
 	cin >> fileName;
+
+	//the code and the message together have to fit the memory budget to be held
+	if (memory.budget() > 0)
+	{
+		ifstream inFile;
+		inFile.open(fileName, ios::binary | ios::ate);
+		unsigned long long size = inFile ? (unsigned long long)inFile.tellg() : 0;
+		char kind = '\0';
+		inFile.seekg(0);
+		readPackedHeader(inFile, kind, size);
+		inFile.close();
+		if (!memory.fits(2 * (size_t)size + 1))
+		{
+			decodeBlocks(fileName);
+			return;
+		}
+	}
+
+	//read code from file, text or packed
+	memoryPhase memPhase(memory, PHASE_READ);
+	fullCode.clear();
+	fullCode.shrink_to_fit();
+	if (!readCode(fileName, fullCode))
+		return;
+
+	//a stored file is copied out as it is
+	if (!fullCode.empty() && fullCode[0] == STORED_FLAG)
+	{
+		cout << "\n\nMessage Decoded: " << endl;
+		cout.write(fullCode.data() + 1, fullCode.size() - 1);
+		cout << endl;
+		return;
+	}
+	if (nodes.empty())
+	{
+		cout << "No tree has been constructed to decode with" << endl;
+		return;
+	}
+
+	//current node starts at the root, walked by pointer so no node is copied per bit
+	const huffNode* root = &nodes[nodes.size() - 1];
+	const huffNode* curr = root;
+
+	//decoded message starts empty
+	memory.setPhase(PHASE_DECODE);
+	accountedString ans(inString.get_allocator());
+	ans.reserve(fullCode.size() / 2);
+
+	{
+		profileScope phase(profiler, PHASE_DECODE, 0);
+
+		//decode the message
+		for (unsigned i = 0; i < fullCode.size(); i++)
+		{
+			//if 0 go left, if 1 go right
+			curr = (fullCode[i] == '0') ? curr->left : curr->right;
+
+			//if current is a leaf node
+			if (curr->left == NULL)
+			{
+				//get the current character value
+				ans += curr->name[0];
+
+				//reset current to the root
+				curr = root;
+			}
+		}
+		phase.bytes = ans.size();
+	}
+	cout << "\n\nMessage Decoded: " << endl;
+	cout << ans << endl;
+	
+}
+
+/*******************************************************************************************
+*	Function Name:			decodeBlocks
+*	Purpose:				Decodes an encoded file a block of code at a time, printing
+*							each block's characters as they are decoded, so neither the
+*							code nor the message is ever held whole
+*	Input Parameters:		string fileName		the encoded file, text or packed
+*	Return value:			none
+********************************************************************************************/
+void Huffman::decodeBlocks(const string& fileName)
+{
 	ifstream inFile;
-	inFile.open(fileName);
+	inFile.open(fileName, ios::binary);
 	if (!inFile)
 	{
 		cout << "Error opening file " << fileName << endl;
 		return;
 	}
+	char kind = '\0';
+	unsigned long long bitsLeft = 0;
+	bool packed = readPackedHeader(inFile, kind, bitsLeft);
+	bool stored = packed ? (kind == PACKED_STORED) : (inFile.peek() == STORED_FLAG);
+	if (!stored && nodes.empty())
+	{
+		cout << "No tree has been constructed to decode with" << endl;
+		return;
+	}
+	cout << "The code does not fit the memory budget, decoding it a block at a time" << endl;
+	cout << "\n\nMessage Decoded: " << endl;
 
-	//code starts empty
-	fullCode = "";
+	//stored characters are copied out up to their end
+	if (stored)
+	{
+		char buffer[READ_BLOCK];
+		if (!packed)
+			inFile.get();
+		while (inFile.read(buffer, READ_BLOCK) || inFile.gcount() > 0)
+		{
+			size_t count = (size_t)inFile.gcount();
+			size_t end = packed ? (size_t)min((unsigned long long)count, bitsLeft)
+				: findTerminator(buffer, count);
+			cout.write(buffer, end);
+			bitsLeft -= min((unsigned long long)end, bitsLeft);
+			if (end < count)
+				break;
+		}
+		cout << endl;
+		return;
+	}
 
-	//read code from file, terminating at *
-	inFile >> fullCode;
-	for (unsigned i = 0; i < fullCode.size(); i++)
+	//code is decoded a block at a time, the walk down the tree carrying on across blocks
+	memoryPhase memPhase(memory, PHASE_DECODE);
+	profileScope phase(profiler, PHASE_DECODE, 0);
+	const huffNode* root = &nodes[nodes.size() - 1];
+	const huffNode* curr = root;
+	accountedString ans(inString.get_allocator());
+	ans.reserve(blockSize());
+	string block;
+	size_t firstBit = 0;
+	while (nextCodeBlock(inFile, packed, firstBit, bitsLeft, block))
 	{
-		if (fullCode[i] == '*')
+		size_t end = findTerminator(block.data(), block.size());
+		for (size_t i = 0; i < end; i++)
 		{
-			fullCode.erase(i, fullCode.size());
-			break;
+			curr = (block[i] == '0') ? curr->left : curr->right;
+			if (curr->left == NULL)
+			{
+				ans += curr->name[0];
+				curr = root;
+				if (ans.size() == blockSize())
+				{
+					cout << ans;
+					phase.bytes += ans.size();
+					ans.clear();
+				}
+			}
 		}
-	}	
-	
+		if (end < block.size())
+			break;
+	}
+	cout << ans << endl;
+	phase.bytes += ans.size();
 	inFile.close();
+}
 
-	//current node starts at the root
-	huffNode curr = nodes[nodes.size() - 1];
+/*******************************************************************************************
+*	Function Name:			append
+*	Purpose:				Encodes another file with the current tree and adds its code
+*							to the end of an existing encoded file, extending that file's
+*							checkpoint index, without reading or re-encoding the old code.
+*							Packed files are refused
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Huffman::append()
+{
+	//new text to add
+	string fileName;
+	accountedString text(inString.get_allocator());
+	cout << "Enter the input file to append: ";
+	cin >> fileName;
+	if (!readText(fileName, text))
+		return;
 
-	//decoded message starts empty
-	string ans = "";
+	//encoded file to add it to
+	cout << "Enter the name of the encoded file to append to: ";
+	cin >> fileName;
+	fstream codeFile;
+	codeFile.open(fileName, ios::in | ios::out);
+	if (!codeFile)
+	{
+		cout << "Error opening file " << fileName << endl;
+		return;
+	}
 
-	//decode the message
-	for (unsigned i = 0; i < fullCode.size(); i++)
+	//a packed file ends in code bits, whose last byte can be the terminating character too,
+	//so it is told apart by its header
+	char kind = '\0';
+	unsigned long long count = 0;
+	if (readPackedHeader(codeFile, kind, count))
 	{
-		//if 0 go left
-		if (fullCode[i] == '0')
-			curr = *curr.left;
+		cout << fileName << " is packed, only encoded text files can be appended to" << endl;
+		return;
+	}
 
-		//if 1 go right
-		else
-			curr = *curr.right;
+	//the old code ends at the terminating character, the last byte of the file
+	codeFile.seekg(0, ios::end);
+	streamoff codeEnd = codeFile.tellg() - (streamoff)1;
+	char last = '\0';
+	if (codeEnd >= 0)
+	{
+		codeFile.seekg(codeEnd);
+		codeFile.get(last);
+	}
+	if (last != '*')
+	{
+		cout << fileName << " is not an encoded file" << endl;
+		return;
+	}
 
-		//if current is a leaf node
-		if (curr.left == NULL && curr.right == NULL)
+	//a stored file takes the new characters as they are
+	char first = '\0';
+	codeFile.seekg(0);
+	codeFile.get(first);
+	if (first == STORED_FLAG)
+	{
+		codeFile.seekp(codeEnd);
+		codeFile << text << '*';
+		codeFile.close();
+		cout << "\n\n" << text.size() << " characters appended to " << fileName << endl;
+		return;
+	}
+	if (nodes.empty())
+	{
+		cout << "No tree has been constructed to encode with" << endl;
+		return;
+	}
+
+	//find the last checkpoint so only the code after it is decoded to count characters
+	checkpoint start = { 0, 0 };
+	checkpoint next;
+	bool indexed = false;
+	ifstream idxFile;
+	idxFile.open(fileName + ".idx");
+	while (idxFile >> next.symbol >> next.bit)
+	{
+		start = next;
+		indexed = true;
+	}
+	idxFile.close();
+	unsigned symbols = 0;
+	if (indexed)
+		symbols = start.symbol + (unsigned)decodeRange(fileName, start.symbol, UINT_MAX).size();
+
+	//encode the new text, continuing the checkpoint spacing from the last checkpoint
+	string code = "";
+	vector<checkpoint> checkpoints;
+	size_t nextCheckpoint = start.bit + checkpointInterval;
+	for (unsigned i = 0; i < text.size(); i++)
+	{
+		size_t bit = (size_t)codeEnd + code.size();
+		if (indexed && checkpointInterval > 0 && bit >= nextCheckpoint)
 		{
+			checkpoints.push_back({ symbols + i, bit });
+			nextCheckpoint = bit + checkpointInterval;
+		}
+		code += codeTable[text[i] - FIRST_CHAR];
+	}
 
-			//get the current character value
-			ans += curr.name;
+	//overwrite the old terminating character with the new code
+	codeFile.seekp(codeEnd);
+	codeFile << code << '*';
+	codeFile.close();
+	cout << "\n\n" << text.size() << " characters appended to " << fileName << endl;
 
-			//reset current to the root
-			curr = nodes[nodes.size() - 1];
+	//add the new checkpoints to the end of the index
+	if (!checkpoints.empty())
+	{
+		ofstream outFile;
+		outFile.open(fileName + ".idx", ios::app);
+		for (unsigned i = 0; i < checkpoints.size(); i++)
+			outFile << checkpoints[i].symbol << " " << checkpoints[i].bit << endl;
+		outFile.close();
+	}
+}
+
+
+/*******************************************************************************************
+*	Function Name:			convert
+*	Purpose:				Rewrites encoded text files, code as '0' and '1' characters,
+*							as packed files holding eight code bits per byte, reading and
+*							writing a block at a time. Each file's checkpoint index still
+*							holds, so it is copied next to the packed file. A stored file
+*							becomes a stored packed file and needs no index
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Huffman::convert()
+{
+	string fileName;
+	cout << "Enter the encoded files to convert, ending with *: ";
+	while (cin >> fileName && fileName != "*")
+	{
+		ifstream inFile;
+		inFile.open(fileName, ios::binary);
+		if (!inFile)
+		{
+			cout << "Error opening file " << fileName << endl;
+			continue;
+		}
+		char kind = '\0';
+		unsigned long long count = 0;
+		if (readPackedHeader(inFile, kind, count))
+		{
+			cout << fileName << " is already packed" << endl;
+			continue;
+		}
+
+		//the header is written again once the size is known
+		string packedName = fileName + ".pk";
+		ofstream outFile;
+		outFile.open(packedName, ios::binary);
+		kind = (inFile.peek() == STORED_FLAG) ? PACKED_STORED : PACKED_CODE;
+		if (kind == PACKED_STORED)
+			inFile.get();
+		writePackedHeader(outFile, kind, 0);
+
+		//pack a block at a time, holding back only a partly filled last byte
+		char buffer[READ_BLOCK];
+		vector<unsigned char> packed;
+		size_t bits = 0;
+		unsigned long long read = 0;
+		bool done = false;
+		bool valid = true;
+		while (!done && (inFile.read(buffer, READ_BLOCK) || inFile.gcount() > 0))
+		{
+			size_t size = (size_t)inFile.gcount();
+			size_t end = findTerminator(buffer, size);
+			done = (end < size);
+			if (kind == PACKED_STORED)
+			{
+				outFile.write(buffer, end);
+				count += end;
+				continue;
+			}
+			size_t used = packBitText(buffer, end, packed, bits);
+			read += used;
+			if (used < end)
+			{
+				cout << fileName << " has a character other than 0 or 1 at " << read << endl;
+				valid = false;
+				break;
+			}
+			outFile.write((const char*)packed.data(), bits / 8);
+			count += bits - bits % 8;
+			if (bits % 8 != 0)
+				packed[0] = packed[bits / 8];
+			packed.resize(bits % 8 == 0 ? 0 : 1);
+			bits %= 8;
+		}
+		if (!packed.empty())
+		{
+			outFile.write((const char*)packed.data(), 1);
+			count += bits;
 		}
+		inFile.close();
+		if (!valid)
+		{
+			outFile.close();
+			remove(packedName.c_str());
+			continue;
+		}
+		outFile.seekp(0);
+		writePackedHeader(outFile, kind, count);
+		outFile.close();
+
+		ifstream sizeFile;
+		sizeFile.open(packedName, ios::binary | ios::ate);
+		streamoff packedSize = sizeFile.tellg();
+		sizeFile.close();
+
+		//code bits are where they were, so the index is copied as it is
+		ifstream idxFile;
+		idxFile.open(fileName + ".idx", ios::binary);
+		if (idxFile && kind == PACKED_CODE)
+		{
+			outFile.open(packedName + ".idx", ios::binary);
+			outFile << idxFile.rdbuf();
+			outFile.close();
+		}
+		cout << fileName << " converted to " << packedName << ", " << packedSize << " bytes" << endl;
 	}
-	cout << "\n\nMessage Decoded: " << endl;
-	cout << ans << endl;
-	
+}
+
+
+/*******************************************************************************************
+*	Function Name:			setProfiling
+*	Purpose:				Turns reading the hardware counters around the histogram,
+*							build, encode and decode phases on or off, clearing the counts
+*							when it is turned on
+*	Input Parameters:		bool on				true to profile
+*	Return value:			none
+********************************************************************************************/
+void Huffman::setProfiling(bool on)
+{
+	if (!on)
+	{
+		profiler.disable();
+		return;
+	}
+	profiler.reset();
+	if (profiler.enable())
+		cout << "Profiling the phases of coding" << endl;
+	else
+		cout << "The hardware counters are not available, timing the phases only" << endl;
+}
+
+/*******************************************************************************************
+*	Function Name:			printProfile
+*	Purpose:				Prints the time and hardware counts of each phase per MB
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Huffman::printProfile()
+{
+	profiler.report(cout);
+}
+
+/*******************************************************************************************
+*	Function Name:			setMemoryBudget
+*	Purpose:				Sets the most bytes the input, code and message buffers may
+*							take at once. Input or code that would not fit is read, coded
+*							and decoded a block at a time instead
+*	Input Parameters:		size_t bytes		the budget, 0 for none
+*	Return value:			none
+********************************************************************************************/
+void Huffman::setMemoryBudget(size_t bytes)
+{
+	memory.setBudget(bytes);
+}
+
+/*******************************************************************************************
+*	Function Name:			printMemory
+*	Purpose:				Prints the memory the buffers take and took in each phase
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Huffman::printMemory()
+{
+	memory.report(cout);
+}
+
+/*******************************************************************************************
+*	Function Name:			memoryAccount
+*	Purpose:				Returns the account the buffers allocate through, to set its
+*							hooks or read its totals
+*	Input Parameters:		none
+*	Return value:			MemoryAccount&		the account
+********************************************************************************************/
+MemoryAccount& Huffman::memoryAccount()
+{
+	return memory;
 }
 
 /*******************************************************************************************
@@ -267,88 +1085,339 @@ void Huffman::printTable()
 
 /*******************************************************************************************
 *	Function Name:			readFile
-*	Purpose:				Reads a file and initializes the input string
+*	Purpose:				Reads a file and initializes the input string, or only finds
+*							the file when its text does not fit the memory budget or is
+*							sampled, so it is read a block at a time each time it is needed
 *	Input Parameters:		none
-*	Return value:			none
+*	Return value:			bool				false if the file could not be opened
 ********************************************************************************************/
-void Huffman::readFile()
+bool Huffman::readFile()
 {
+	memoryPhase memPhase(memory, PHASE_READ);
+	profileScope phase(profiler, PHASE_READ, 0);
 
-	//if the tree already has data in it
-	if (populated)
-	{
-		//reset all of the data
-		input.erase(input.begin(), input.end());
-		nodes.erase(nodes.begin(), nodes.end());
-		inString = "";
-		fullCode = "";
-	}
+	//reset the input, giving its memory back, the tree is kept in case encode reuses it
+	inString.clear();
+	inString.shrink_to_fit();
+	fullCode.clear();
+	fullCode.shrink_to_fit();
+	textStreamed = false;
+	textLength = 0;
 
 	//input file
 	string fileName;
-	ifstream inFile;
-	char temp;
 	cout << "Enter the input file from which to construct the Huffman tree " << endl;
 	cin >> fileName;
+	textName = fileName;
+
+	//the text is at most the file's size, so a file that fits is read with one allocation
+	ifstream inFile;
+	inFile.open(fileName, ios::binary | ios::ate);
+	bool found = inFile.is_open();
+	size_t fileSize = found ? (size_t)inFile.tellg() : 0;
+	inFile.close();
+	if (!memory.fits(fileSize + 1))
+		cout << "The input does not fit the memory budget, reading it a block at a time" << endl;
+
+	//a sampled file is only read in full once, when it is encoded
+	if (!memory.fits(fileSize + 1) || sampleStride > 1)
+	{
+		if (!found)
+		{
+			cout << "Error opening file " << fileName << endl;
+			return false;
+		}
+		textStreamed = true;
+		populated = true;
+		return true;
+	}
+	inString.reserve(fileSize);
+	if (!readText(fileName, inString))
+		return false;
+	textLength = inString.size();
+	phase.bytes = textLength;
+
+	//the tree now has data
+	populated = true;
+	return true;
+}
+
+
+/*******************************************************************************************
+*	Function Name:			readText
+*	Purpose:				Reads a file up to its terminating character, skipping
+*							whitespace and making everything lowercase
+*	Input Parameters:		string fileName		the file to read
+*							accountedString text	the string the characters are added to
+*	Return value:			bool				false if the file could not be opened
+********************************************************************************************/
+bool Huffman::readText(const string& fileName, accountedString& text)
+{
+	ifstream inFile;
 	inFile.open(fileName);
 	if (!inFile)
 	{
 		cout << "Error opening file " << fileName << endl;
-		return;
+		return false;
 	}
 
-	//while the file still has data
-	while (inFile)
-	{
-		//read into character
-		inFile >> temp;
+	//read the file a block at a time through one reusable buffer
+	accountedString block(text.get_allocator());
+	while (nextTextBlock(inFile, block))
+		text += block;
+	inFile.close();
+	return true;
+}
 
-		//make everything lowercase
-		temp = tolower(temp);
+/*******************************************************************************************
+*	Function Name:			nextTextBlock
+*	Purpose:				Reads the next block of a file's text, skipping whitespace and
+*							making everything lowercase, up to its terminating character
+*	Input Parameters:		ifstream inFile		the file, at the next text to read
+*							accountedString block	the characters read
+*	Return value:			bool				false once there is no more text
+********************************************************************************************/
+bool Huffman::nextTextBlock(ifstream& inFile, accountedString& block)
+{
+	block.clear();
+	block.reserve(blockSize());
+	char buffer[READ_BLOCK];
+	while (block.empty() && (inFile.read(buffer, blockSize()) || inFile.gcount() > 0))
+	{
+		streamsize count = inFile.gcount();
+		for (streamsize i = 0; i < count; i++)
+		{
+			//stop on terminating character, leaving nothing more to read
+			if (buffer[i] == '*')
+			{
+				inFile.setstate(ios::eofbit | ios::failbit);
+				break;
+			}
 
-		//push into input vector
-		input.push_back(temp);
+			//skip whitespace and make everything lowercase
+			if (!isspace((unsigned char)buffer[i]))
+				block.push_back(tolower(buffer[i]));
+		}
+	}
+	return !block.empty();
+}
 
-		//break on terminating character
-		if (inFile.peek() == '*')
-			break;
+/*******************************************************************************************
+*	Function Name:			forTextBlocks
+*	Purpose:				Hands the input text to a function, all at once when it is
+*							held, or a block at a time from its file when it is not
+*	Input Parameters:		function use		called with each block and its size
+*	Return value:			bool				false if the file could not be opened
+********************************************************************************************/
+bool Huffman::forTextBlocks(const function<void(const char*, size_t)>& use)
+{
+	if (!textStreamed)
+	{
+		if (!inString.empty())
+			use(inString.data(), inString.size());
+		return true;
 	}
+	ifstream inFile;
+	inFile.open(textName);
+	if (!inFile)
+	{
+		cout << "Error opening file " << textName << endl;
+		return false;
+	}
+	accountedString block(inString.get_allocator());
+	while (nextTextBlock(inFile, block))
+		use(block.data(), block.size());
 	inFile.close();
+	return true;
+}
 
-	//copy input into string to save original ordering
-	for (unsigned i = 0; i < input.size(); i++)
-		inString.push_back(input[i]);
+/*******************************************************************************************
+*	Function Name:			blockSize
+*	Purpose:				Finds how many characters to read or code at a time, fewer
+*							than READ_BLOCK when a small memory budget is set
+*	Input Parameters:		none
+*	Return value:			size_t				the characters per block
+********************************************************************************************/
+size_t Huffman::blockSize()
+{
+	if (memory.budget() == 0)
+		return READ_BLOCK;
+	return max((size_t)MIN_BLOCK, min((size_t)READ_BLOCK, memory.budget() / 16));
+}
 
-	//sort input vector
-	sort(input.begin(), input.end());
 
-	//the tree now has data
-	populated = true;
+/*******************************************************************************************
+*	Function Name:			nextCodeBlock
+*	Purpose:				Reads the next block of an encoded file's code as '0' and '1'
+*							characters, unpacking it when the file is packed
+*	Input Parameters:		ifstream inFile		the encoded file, at the next code to read
+*							bool packed			whether the file holds packed bits
+*							size_t firstBit		the bit of the first packed byte to start
+*												at, set to 0 once used
+*							unsigned long long bitsLeft	packed code bits left to read
+*							string block		the characters read
+*	Return value:			bool				false once there is no more code
+********************************************************************************************/
+bool Huffman::nextCodeBlock(ifstream& inFile, bool packed, size_t& firstBit,
+	unsigned long long& bitsLeft, string& block)
+{
+	block.clear();
+	if (!packed)
+	{
+		block.resize(READ_BLOCK);
+		inFile.read(&block[0], READ_BLOCK);
+		block.resize((size_t)inFile.gcount());
+		return !block.empty();
+	}
 
+	//a packed file ends when its bits do, it has no terminating character
+	unsigned char buffer[READ_BLOCK / 8];
+	size_t want = (size_t)min((unsigned long long)READ_BLOCK / 8, (firstBit + bitsLeft + 7) / 8);
+	if (want == 0)
+		return false;
+	inFile.read((char*)buffer, want);
+	size_t bits = (size_t)inFile.gcount() * 8;
+	if (bits <= firstBit)
+		return false;
+	bits = (size_t)min((unsigned long long)(bits - firstBit), bitsLeft);
+	unpackBitText(buffer, firstBit, bits, block);
+	bitsLeft -= bits;
+	firstBit = 0;
+	return true;
+}
+
+/*******************************************************************************************
+*	Function Name:			readCode
+*	Purpose:				Reads an encoded file's code up to its end, as '0' and '1'
+*							characters, or STORED_FLAG and the characters of a stored file
+*	Input Parameters:		string fileName		the encoded file, text or packed
+*							accountedString code	the string the code is added to
+*	Return value:			bool				false if the file could not be opened
+********************************************************************************************/
+bool Huffman::readCode(const string& fileName, accountedString& code)
+{
+	ifstream inFile;
+	inFile.open(fileName, ios::binary);
+	if (!inFile)
+	{
+		cout << "Error opening file " << fileName << endl;
+		return false;
+	}
+	char kind = '\0';
+	unsigned long long bitsLeft = 0;
+	bool packed = readPackedHeader(inFile, kind, bitsLeft);
+
+	//stored characters are copied as they are
+	if (packed && kind == PACKED_STORED)
+	{
+		code += STORED_FLAG;
+		size_t used = code.size();
+		code.resize(used + (size_t)bitsLeft);
+		if (bitsLeft > 0)
+			inFile.read(&code[used], (streamsize)bitsLeft);
+		code.resize(used + (size_t)inFile.gcount());
+		inFile.close();
+		return true;
+	}
+
+	//text code stops at the terminating character
+	string block;
+	size_t firstBit = 0;
+	while (nextCodeBlock(inFile, packed, firstBit, bitsLeft, block))
+	{
+		size_t end = findTerminator(block.data(), block.size());
+		code.append(block.data(), end);
+		if (end < block.size())
+			break;
+	}
+	inFile.close();
+	return true;
 }
 
 
 /*******************************************************************************************
-*	Function Name:			countChars
-*	Purpose:				Counts the characters in the input vector and assignes a 
-*							frequency to them, adding them to a vector of nodes
+*	Function Name:			histogram
+*	Purpose:				Counts the characters in the input, setting textLength, or when
+*							sampling counts one block in every sampleStride, seeking past
+*							the others unread, and estimates textLength from them
 *	Input Parameters:		none
+*	Return value:			vector<int>			the count of each character from 'a'
+********************************************************************************************/
+vector<int> Huffman::histogram()
+{
+	vector<int> freq(ALPHABET_SIZE, 0);
+	textLength = 0;
+	if (sampleStride == 1)
+	{
+		forTextBlocks([&](const char* text, size_t size)
+		{
+			for (size_t i = 0; i < size; i++)
+				freq[text[i] - FIRST_CHAR]++;
+			textLength += size;
+		});
+		return freq;
+	}
+	ifstream inFile;
+	inFile.open(textName);
+	if (!inFile)
+	{
+		cout << "Error opening file " << textName << endl;
+		return freq;
+	}
+	accountedString block(inString.get_allocator());
+	while (nextTextBlock(inFile, block))
+	{
+		//a terminating character in a block seeked past leaves what follows it to be
+		//read, which need not be letters
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			int letter = block[i] - FIRST_CHAR;
+			if (letter >= 0 && letter < ALPHABET_SIZE)
+				freq[letter]++;
+		}
+		textLength += block.size() * sampleStride;
+		inFile.seekg((streamoff)(sampleStride - 1) * (streamoff)blockSize(), ios::cur);
+	}
+	inFile.close();
+	return freq;
+}
+
+/*******************************************************************************************
+*	Function Name:			tableBits
+*	Purpose:				Finds the number of code bits the current code table uses
+*							for a set of frequencies
+*	Input Parameters:		vector<int> freq	the frequency of each character
+*	Return value:			size_t				the total code bits
+********************************************************************************************/
+size_t Huffman::tableBits(const vector<int>& freq)
+{
+	size_t bits = 0;
+	for (unsigned i = 0; i < freq.size(); i++)
+		bits += (size_t)freq[i] * codeTable[i].size();
+	return bits;
+}
+
+/*******************************************************************************************
+*	Function Name:			countChars
+*	Purpose:				Assigns a frequency to each character from its count, adding
+*							them to a vector of nodes
+*	Input Parameters:		vector<int> freq	the count of each character from 'a'
 *	Return value:			none
 ********************************************************************************************/
-void Huffman::countChars()
+void Huffman::countChars(const vector<int>& freq)
 {
-	int count = 1;
 	huffNode newNode;
 	
 	//start at a
-	char curr = 'a';
+	char curr = FIRST_CHAR;
 
 	//loop from a to z
-	for (int i = 0; i < 26; i++)
+	for (int i = 0; i < ALPHABET_SIZE; i++)
 	{
-		//set node information for each character
+		//set node information for each character, a sampled count gives every
+		//character a weight of at least one so none is left without a fair code
 		newNode.name = curr;
-		newNode.freq = 0;
+		newNode.freq = freq[i] + ((sampleStride > 1) ? 1 : 0);
 		newNode.code = "";
 		newNode.left = NULL;
 		newNode.right = NULL;
@@ -358,13 +1427,7 @@ void Huffman::countChars()
 		curr++;
 	}
 	
-	//count each character
-	for (unsigned i = 0; i < input.size(); i++)
-	{
-		nodes[input[i] - 97].freq++;
-	}
-	
-	//sort the array of nodes
-	sort(nodes.begin(), nodes.end());
+	//sort the array of nodes, ties stay in alphabetical order
+	stable_sort(nodes.begin(), nodes.end());
 
 }
@@ -16,24 +16,59 @@
 *		huffNode					a struct holding the name of a node, the assigned huffman code
 *									and pointers to left and right children as well as the parent
 *									node; includes operator overloads for < and <<
+*		checkpoint					the character index and code bit where a
+*									character's code starts in an encoded file
 *		
 *	Private data members:
 *		bool populated				determines whether a tree has data in it or not
 *		vector<huffNode> nodes		vector of nodes representing the huffman tree
-*		vector<char> input			the input string which gets reordered
-*		string inString				the original string
-*		string fullCode				the encoded input or output
+*		MemoryAccount memory		the account the text, code and message buffers allocate through
+*		accountedString inString	the original string
+*		accountedString fullCode	the encoded input or output
+*		string textName				the input file
+*		bool textStreamed			whether the input is read a block at a time, not held
+*		size_t textLength			the characters in the input
+*		string codeTable[]			the code for each character, indexed from FIRST_CHAR
+*		int checkpointInterval		code bits between checkpoints, 0 for none
+*		int sampleStride			count one block of text in every sampleStride, 1 for all
+*		Profiler profiler			the hardware counters read around each phase of coding
 *	
 *	Private member function:
 *		void makeTree				constructs the huffman tree
-*		void readFile				reads the input file to make the tree from
-*		void countChars				counts the characters and assigns a frequency to each node
+*		void buildTree				constructs the huffman tree from the codes in codeTable
+*		bool readFile				reads the input file to make the tree from
+*		void countChars				assigns a frequency to each node from the character counts
+*		vector<int> histogram		counts the characters in the input
+*		size_t tableBits			the code bits the current table uses for a set of frequencies
+*		bool readText				reads a file's characters up to its terminating character
+*		bool nextTextBlock			reads the next block of a file's characters
+*		bool forTextBlocks			hands the input to a function a block at a time
+*		size_t blockSize			the characters read or coded at a time
+*		void decodeBlocks			decodes a file a block of code at a time
+*		size_t optimalBits			the code bits the best table for a set of frequencies uses
+*		bool isIncompressible		whether code saves too little over storing its characters
+*		bool nextCodeBlock			reads the next block of code from a text or packed file
+*		bool readCode				reads all of an encoded file's code, text or packed
 *
 *	Public member functions:
 *		Huffman				constructor for a Huffman tree
 *		
-*		void encode			encodes a string according to the huffman tree
+*		void encode			encodes a string according to the huffman tree, keeping
+*							the current tree when it codes the new input as cheaply,
+*							or stores it as is when coding would save too little
 *		void decode			decodes a string according to the huffman tree
+*		setCheckpoints		sets the code bits between checkpoints written by encode
+*		decodeRange			decodes part of an encoded file from its nearest checkpoint
+*		useFixedTable		loads the compile time English code table
+*		setSampleStride		sets how often the input is sampled when counting characters
+*		void convert		rewrites encoded text files as packed files of real bits
+*		setMemoryBudget		sets the most memory the buffers may take at once
+*		printMemory			prints the memory the buffers took in each phase
+*		memoryAccount		the account the buffers allocate through
+*		setProfiling		turns reading the hardware counters around each phase on or off
+*		printProfile		prints each phase's counts per MB
+*		void append			encodes another file with the current tree onto the end of
+*							an existing encoded text file
 *		printTree			prints out each node with their corresponding
 *							child and parent pointers
 *		printTable			prints out the table of codes for each character
@@ -44,8 +79,16 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <fstream>
+#include <functional>
+#include "Profiler.h"
+#include "Memory.h"
 using namespace std;
 
+//the characters the Huffman class codes, FIRST_CHAR and the ALPHABET_SIZE - 1 after it
+const int ALPHABET_SIZE = 26;
+const char FIRST_CHAR = 'a';
+
 //huffNode struct to hold each character
 struct huffNode
 {
@@ -57,7 +100,7 @@ struct huffNode
 	huffNode* parent;
 	
 	//< overload for sorting
-	bool operator<(const huffNode node)
+	bool operator<(const huffNode& node) const
 	{
 		
 		if (this->freq < node.freq)
@@ -74,6 +117,13 @@ struct huffNode
 	}
 };
 
+//checkpoint struct to locate a character inside an encoded file
+struct checkpoint
+{
+	unsigned symbol;
+	size_t bit;
+};
+
 //huffman tree class
 class Huffman
 {
@@ -81,18 +131,49 @@ public:
 	Huffman();	
 	void encode();
 	void decode();
+	void setCheckpoints(int interval);
+	string decodeRange(const string& fileName, unsigned offset, unsigned length);
+	void append();
+	void setSampleStride(int stride);
+	void useFixedTable();
+	void convert();
+	void setMemoryBudget(size_t bytes);
+	void printMemory();
+	MemoryAccount& memoryAccount();
+	void setProfiling(bool on);
+	void printProfile();
 	void printTree();
 	void printTable();
 	
 	
 private:
 	void makeTree();
-	void readFile();
-	void countChars();
+	void buildTree(const vector<int>& freq);
+	bool readFile();
+	void countChars(const vector<int>& freq);
+	vector<int> histogram();
+	size_t tableBits(const vector<int>& freq);
+	bool readText(const string& fileName, accountedString& text);
+	bool nextTextBlock(ifstream& inFile, accountedString& block);
+	bool forTextBlocks(const function<void(const char*, size_t)>& use);
+	size_t blockSize();
+	void decodeBlocks(const string& fileName);
+	bool nextCodeBlock(ifstream& inFile, bool packed, size_t& firstBit, unsigned long long& bitsLeft,
+		string& block);
+	bool readCode(const string& fileName, accountedString& code);
+	size_t optimalBits(const vector<int>& freq);
+	bool isIncompressible(unsigned long long codeBits, unsigned long long characters);
 	vector<huffNode> nodes;
-	vector<char> input;
-	string inString;
-	string fullCode;
+	MemoryAccount memory;
+	accountedString inString;
+	accountedString fullCode;
+	string textName;
+	bool textStreamed;
+	size_t textLength;
+	string codeTable[ALPHABET_SIZE];
+	int checkpointInterval;
+	int sampleStride;
+	Profiler profiler;
 	bool populated;
 	
 };
@@ -0,0 +1,194 @@
+/**************************************************************************************************
+*
+*   File name :			IntegerCodec.h
+*
+*   Header file for the integerCodec class template, which codes columns of unsigned integers
+*	such as timestamp deltas, IDs and sizes. Each value is split into a bucket symbol, its bit
+*	length and the bit after its top bit, which is Huffman coded with a codec, and the rest of
+*	its bits, which are stored raw as extra bits, in the way DEFLATE codes lengths. A column can
+*	first be turned into zigzagged differences between neighbours so sorted or slowly changing
+*	columns land in small buckets.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		integerCodec<Integer>
+*
+*	Private data members:
+*		columnMode mode				whether values are coded as they are or as differences
+*		codec<uint8_t, BUCKETS> buckets		the Huffman coder for the bucket symbols
+*
+*	Private member functions:
+*		Integer prepare				applies the transform to a value
+*		void split					turns values into bucket symbols, applying the transform
+*
+*	Public member functions:
+*		integerCodec		constructor for a codec with the given transform
+*		void count			adds the buckets of an array of values to the counts
+*		bool build			computes the bucket codes from the counts
+*		size_t encode		codes an array of values into bucket code and extra bits
+*		size_t decode		rebuilds an array of values from bucket code and extra bits
+*
+****************************************************************************************************/
+#ifndef INTEGERCODEC_H
+#define INTEGERCODEC_H
+#include "Codec.h"
+
+//how values are turned into symbols before coding
+enum columnMode
+{
+	RAW_COLUMN,		//each value as it is
+	DELTA_COLUMN		//the zigzagged difference from the value before it
+};
+
+//integerCodec class template for arrays of unsigned integers
+template <class Integer>
+class integerCodec
+{
+	static_assert(!numeric_limits<Integer>::is_signed, "integerCodec values must be unsigned");
+
+public:
+	//bits in a value, and one bucket for 0, one for 1 and two for each longer bit length
+	static const int BITS = numeric_limits<Integer>::digits;
+	static const int BUCKETS = 2 * BITS;
+
+	integerCodec(columnMode mode = RAW_COLUMN);
+	void count(const Integer* data, size_t size);
+	bool build();
+	size_t encode(const Integer* data, size_t size, vector<unsigned char>& code,
+		vector<unsigned char>& extra) const;
+	size_t decode(const unsigned char* code, size_t bits, const unsigned char* extra,
+		size_t extraBits, Integer* out, size_t size) const;
+
+private:
+	Integer prepare(Integer value, Integer& previous) const;
+	void split(const Integer* data, size_t size, vector<uint8_t>& symbols) const;
+	columnMode mode;
+	codec<uint8_t, BUCKETS> buckets;
+};
+
+//the common column codecs
+typedef integerCodec<uint32_t> intColumnCodec;
+typedef integerCodec<uint64_t> longColumnCodec;
+
+//constructor
+template <class Integer>
+integerCodec<Integer>::integerCodec(columnMode mode)
+{
+	this->mode = mode;
+}
+
+//applies the transform to a value, previous is the value before it
+template <class Integer>
+Integer integerCodec<Integer>::prepare(Integer value, Integer& previous) const
+{
+	if (mode == RAW_COLUMN)
+		return value;
+
+	//zigzag so small steps either way are small values
+	Integer step = value - previous;
+	previous = value;
+	return (Integer)((step << 1) ^ (0 - (step >> (BITS - 1))));
+}
+
+//turns values into bucket symbols, applying the transform first
+template <class Integer>
+void integerCodec<Integer>::split(const Integer* data, size_t size, vector<uint8_t>& symbols) const
+{
+	symbols.resize(size);
+	Integer previous = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		Integer value = prepare(data[i], previous);
+
+		//the bit length and the bit below the top bit pick the bucket
+		int length = 0;
+		while (length < BITS && (value >> length) != 0)
+			length++;
+		if (length < 2)
+			symbols[i] = (uint8_t)value;
+		else
+			symbols[i] = (uint8_t)(2 * length - 2 + ((value >> (length - 2)) & 1));
+	}
+}
+
+//adds the buckets of an array of values to the counts
+template <class Integer>
+void integerCodec<Integer>::count(const Integer* data, size_t size)
+{
+	vector<uint8_t> symbols;
+	split(data, size, symbols);
+	buckets.count(symbols.data(), symbols.size());
+}
+
+//computes the bucket codes from the counts, returns false if nothing was counted
+template <class Integer>
+bool integerCodec<Integer>::build()
+{
+	return buckets.build();
+}
+
+//codes an array of values, the bucket code onto code and the rest of each value's bits
+//onto extra, returns the number of code bits or 0 if a bucket has no code
+template <class Integer>
+size_t integerCodec<Integer>::encode(const Integer* data, size_t size, vector<unsigned char>& code,
+	vector<unsigned char>& extra) const
+{
+	vector<uint8_t> symbols;
+	split(data, size, symbols);
+	size_t bits = buckets.encode(symbols.data(), symbols.size(), code);
+	if (bits == 0 && size > 0)
+		return 0;
+
+	//the bits below the two that picked the bucket, in the same order
+	unsigned long long acc = 0;
+	int pending = 0;
+	Integer previous = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		Integer value = prepare(data[i], previous);
+		int length = symbols[i] / 2 + 1;
+		if (symbols[i] >= 2 && length > 2)
+			putBits(value & ((((Integer)1) << (length - 2)) - 1), length - 2, acc, pending, extra);
+	}
+	if (pending > 0)
+		extra.push_back((unsigned char)(acc << (8 - pending)));
+	return bits;
+}
+
+//rebuilds up to size values from bits of bucket code and extraBits of extra bits, which is
+//8 times the bytes encode wrote to extra, returns the number of values decoded before
+//either runs out
+template <class Integer>
+size_t integerCodec<Integer>::decode(const unsigned char* code, size_t bits,
+	const unsigned char* extra, size_t extraBits, Integer* out, size_t size) const
+{
+	vector<uint8_t> symbols(size);
+	size_t decoded = buckets.decode(code, bits, symbols.data(), size);
+
+	size_t pos = 0;
+	Integer previous = 0;
+	for (size_t i = 0; i < decoded; i++)
+	{
+		//put the top bit, the bucket's second bit and the extra bits back together
+		Integer value = symbols[i];
+		if (symbols[i] >= 2)
+		{
+			int length = symbols[i] / 2 + 1;
+			if (extraBits - pos < (size_t)(length - 2))
+				return i;
+			value = (Integer)((((Integer)2 | (symbols[i] & 1)) << (length - 2))
+				| getBits(extra, pos, length - 2));
+		}
+		if (mode == DELTA_COLUMN)
+		{
+			//undo the zigzag and add the step back on
+			value = (Integer)((value >> 1) ^ (0 - (value & 1)));
+			value = previous + value;
+			previous = value;
+		}
+		out[i] = value;
+	}
+	return decoded;
+}
+
+#endif // !INTEGERCODEC_H
@@ -0,0 +1,229 @@
+/**************************************************************************************************
+*
+*   File name :			Memory.cpp
+*
+*	Implementation of the MemoryAccount class as defined in Memory.h.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#include "Memory.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+//the C library's allocator, the hooks an account starts with
+static void* libraryAllocate(size_t bytes, void*)
+{
+	return malloc(bytes);
+}
+static void libraryRelease(void* block, size_t, void*)
+{
+	free(block);
+}
+
+/*******************************************************************************************
+*	Function Name:			MemoryAccount		the constructor
+*	Purpose:				Creates an account with no budget that allocates through the
+*							C library, counting in the read phase
+*	Input Parameters:		string name			the context the account is for
+*	Return value:			none
+********************************************************************************************/
+MemoryAccount::MemoryAccount(const string& name)
+{
+	this->name = name;
+	hooks.allocate = libraryAllocate;
+	hooks.release = libraryRelease;
+	hooks.user = NULL;
+	limit = 0;
+	liveBytes = 0;
+	peakBytes = 0;
+	phase = PHASE_READ;
+	memset(totals, 0, sizeof(totals));
+}
+
+/*******************************************************************************************
+*	Function Name:			setHooks
+*	Purpose:				Sets the functions allocations go through. Blocks already live
+*							are freed through the new functions too, so they are best set
+*							before anything is allocated
+*	Input Parameters:		memoryHooks hooks	the functions, both set
+*	Return value:			none
+********************************************************************************************/
+void MemoryAccount::setHooks(const memoryHooks& hooks)
+{
+	lock_guard<mutex> guard(lock);
+	this->hooks = hooks;
+}
+
+/*******************************************************************************************
+*	Function Name:			setBudget
+*	Purpose:				Sets the most bytes that may be live at once
+*	Input Parameters:		size_t bytes		the budget, 0 for none
+*	Return value:			none
+********************************************************************************************/
+void MemoryAccount::setBudget(size_t bytes)
+{
+	lock_guard<mutex> guard(lock);
+	limit = bytes;
+}
+
+/*******************************************************************************************
+*	Function Name:			budget
+*	Purpose:				Returns the most bytes that may be live at once
+*	Input Parameters:		none
+*	Return value:			size_t				the budget, 0 for none
+********************************************************************************************/
+size_t MemoryAccount::budget() const
+{
+	return limit;
+}
+
+/*******************************************************************************************
+*	Function Name:			fits
+*	Purpose:				Finds whether more bytes may be allocated without going over
+*							the budget
+*	Input Parameters:		size_t bytes		the bytes wanted
+*	Return value:			bool				true if there is no budget or they fit
+********************************************************************************************/
+bool MemoryAccount::fits(size_t bytes)
+{
+	lock_guard<mutex> guard(lock);
+	return limit == 0 || (liveBytes <= limit && bytes <= limit - liveBytes);
+}
+
+/*******************************************************************************************
+*	Function Name:			setPhase
+*	Purpose:				Sets the phase allocations are counted in
+*	Input Parameters:		int phase			a profilePhase
+*	Return value:			none
+********************************************************************************************/
+void MemoryAccount::setPhase(int phase)
+{
+	lock_guard<mutex> guard(lock);
+	this->phase = phase;
+	totals[phase].peak = max(totals[phase].peak, liveBytes);
+}
+
+/*******************************************************************************************
+*	Function Name:			currentPhase
+*	Purpose:				Returns the phase allocations are counted in
+*	Input Parameters:		none
+*	Return value:			int					a profilePhase
+********************************************************************************************/
+int MemoryAccount::currentPhase()
+{
+	lock_guard<mutex> guard(lock);
+	return phase;
+}
+
+/*******************************************************************************************
+*	Function Name:			allocate
+*	Purpose:				Allocates bytes through the hooks, counting them in the phase,
+*							or throws bad_alloc if they would go over the budget or the
+*							hooks could not allocate them
+*	Input Parameters:		size_t bytes		the bytes wanted
+*	Return value:			void*				the block
+********************************************************************************************/
+void* MemoryAccount::allocate(size_t bytes)
+{
+	lock_guard<mutex> guard(lock);
+	if (limit > 0 && (liveBytes > limit || bytes > limit - liveBytes))
+		throw bad_alloc();
+	void* block = hooks.allocate(max((size_t)1, bytes), hooks.user);
+	if (block == NULL)
+		throw bad_alloc();
+	liveBytes += bytes;
+	peakBytes = max(peakBytes, liveBytes);
+	totals[phase].allocated += bytes;
+	totals[phase].allocations++;
+	totals[phase].peak = max(totals[phase].peak, liveBytes);
+	return block;
+}
+
+/*******************************************************************************************
+*	Function Name:			release
+*	Purpose:				Frees a block allocated by allocate through the hooks
+*	Input Parameters:		void* block			the block
+*							size_t bytes		the bytes it was allocated with
+*	Return value:			none
+********************************************************************************************/
+void MemoryAccount::release(void* block, size_t bytes)
+{
+	lock_guard<mutex> guard(lock);
+	hooks.release(block, max((size_t)1, bytes), hooks.user);
+	liveBytes -= min(liveBytes, bytes);
+}
+
+/*******************************************************************************************
+*	Function Name:			live
+*	Purpose:				Returns the bytes allocated and not yet freed
+*	Input Parameters:		none
+*	Return value:			size_t				the live bytes
+********************************************************************************************/
+size_t MemoryAccount::live()
+{
+	lock_guard<mutex> guard(lock);
+	return liveBytes;
+}
+
+/*******************************************************************************************
+*	Function Name:			peak
+*	Purpose:				Returns the most bytes ever live since the last reset
+*	Input Parameters:		none
+*	Return value:			size_t				the most live bytes
+********************************************************************************************/
+size_t MemoryAccount::peak()
+{
+	lock_guard<mutex> guard(lock);
+	return peakBytes;
+}
+
+/*******************************************************************************************
+*	Function Name:			phaseTotals
+*	Purpose:				Returns one phase's allocations and most live bytes
+*	Input Parameters:		profilePhase phase	the phase
+*	Return value:			memoryTotals		its totals
+********************************************************************************************/
+memoryTotals MemoryAccount::phaseTotals(profilePhase phase)
+{
+	lock_guard<mutex> guard(lock);
+	return totals[phase];
+}
+
+/*******************************************************************************************
+*	Function Name:			reset
+*	Purpose:				Clears every phase's totals and starts the peak again from
+*							the bytes live now
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void MemoryAccount::reset()
+{
+	lock_guard<mutex> guard(lock);
+	memset(totals, 0, sizeof(totals));
+	peakBytes = liveBytes;
+}
+
+/*******************************************************************************************
+*	Function Name:			report
+*	Purpose:				Prints the live and most live bytes, the budget, and the
+*							allocations and most live bytes of each phase that allocated
+*	Input Parameters:		ostream out			where to print
+*	Return value:			none
+********************************************************************************************/
+void MemoryAccount::report(ostream& out)
+{
+	lock_guard<mutex> guard(lock);
+	out << name << " memory: " << liveBytes << " bytes live, " << peakBytes << " bytes at most";
+	if (limit > 0)
+		out << ", budget " << limit << " bytes";
+	out << endl;
+	for (int p = 0; p < PROFILE_PHASES; p++)
+	{
+		if (totals[p].allocations == 0)
+			continue;
+		out << "    " << PHASE_NAMES[p] << ": " << totals[p].allocations << " allocations of "
+			<< totals[p].allocated << " bytes, " << totals[p].peak << " bytes live at most" << endl;
+	}
+}
@@ -0,0 +1,177 @@
+/**************************************************************************************************
+*
+*   File name :			Memory.h
+*
+*   Header file for the MemoryAccount class, implemented in Memory.cpp, which accounts for the
+*	memory a context such as a Huffman object allocates for its buffers: the bytes and number
+*	of allocations in each phase of coding, the bytes live and the most ever live, in all and
+*	while each phase ran. The buffers allocate through accountedAllocator, which hands every
+*	allocation to the account, and the account allocates through a set of hooks, the C
+*	library's by default, so a program can put its own allocator underneath.
+*
+*	An account may have a budget. An allocation that would take the live bytes over it fails
+*	with bad_alloc before reaching the hooks, and a context checks fits first so that it can
+*	work in smaller blocks instead.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		MemoryAccount
+*
+*	Structs:
+*		memoryHooks					the functions an account allocates and frees through
+*		memoryTotals				the allocations and most live bytes of one phase
+*		memoryPhase					sets an account's phase for as long as it is in scope
+*		accountedAllocator			a standard allocator that allocates through an account
+*
+*	Private data members:
+*		string name					the context the account is for
+*		memoryHooks hooks			the functions allocations go through
+*		size_t limit				the budget in bytes, 0 for none
+*		size_t liveBytes			the bytes allocated and not yet freed
+*		size_t peakBytes			the most bytes ever live
+*		int phase					the phase allocations are counted in
+*		memoryTotals totals[]		each phase's totals
+*		mutex lock					guards the counts, so buffers on several threads may share
+*									an account
+*
+*	Public member functions:
+*		MemoryAccount		constructor for an account with no budget over the C library
+*		setHooks			sets the functions allocations go through
+*		setBudget			sets the most bytes that may be live, 0 for no budget
+*		size_t budget		the budget, 0 for none
+*		bool fits			whether more bytes may be allocated within the budget
+*		setPhase			sets the phase allocations are counted in
+*		int currentPhase	the phase allocations are counted in
+*		void* allocate		allocates bytes through the hooks, counting them
+*		void release		frees bytes allocated by allocate
+*		size_t live			the bytes live
+*		size_t peak			the most bytes ever live
+*		phaseTotals			one phase's totals
+*		void reset			clears the totals and starts the peak again from the live bytes
+*		void report			prints the totals of each phase
+*
+*	Types:
+*		accountedString		a string whose characters are allocated through an account
+*		accountedVector		a vector whose elements are allocated through an account, as the
+*							codecs' tables and the archive and stream buffers are
+*
+****************************************************************************************************/
+#ifndef MEMORY_H
+#define MEMORY_H
+#include <string>
+#include <vector>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include "Profiler.h"
+using namespace std;
+
+//memoryHooks struct holding the functions an account allocates and frees through,
+//and a pointer handed back to them
+struct memoryHooks
+{
+	void* (*allocate)(size_t bytes, void* user);
+	void (*release)(void* block, size_t bytes, void* user);
+	void* user;
+};
+
+//memoryTotals struct adding up the allocations of one phase
+struct memoryTotals
+{
+	unsigned long long allocated;
+	unsigned long long allocations;
+	size_t peak;
+};
+
+//memory account class counting a context's allocations
+class MemoryAccount
+{
+public:
+	MemoryAccount(const string& name);
+	void setHooks(const memoryHooks& hooks);
+	void setBudget(size_t bytes);
+	size_t budget() const;
+	bool fits(size_t bytes);
+	void setPhase(int phase);
+	int currentPhase();
+	void* allocate(size_t bytes);
+	void release(void* block, size_t bytes);
+	size_t live();
+	size_t peak();
+	memoryTotals phaseTotals(profilePhase phase);
+	void reset();
+	void report(ostream& out);
+
+private:
+	string name;
+	memoryHooks hooks;
+	size_t limit;
+	size_t liveBytes;
+	size_t peakBytes;
+	int phase;
+	memoryTotals totals[PROFILE_PHASES];
+	mutex lock;
+};
+
+//memoryPhase struct counting an account's allocations in a phase from its construction
+//to its destruction, then in the phase before
+struct memoryPhase
+{
+	memoryPhase(MemoryAccount& account, profilePhase phase)
+		: account(account), before(account.currentPhase())
+	{
+		account.setPhase(phase);
+	}
+	~memoryPhase()
+	{
+		account.setPhase(before);
+	}
+	MemoryAccount& account;
+	int before;
+};
+
+//accountedAllocator struct, a standard allocator that allocates through an account,
+//or with new when it has none
+template <class T>
+struct accountedAllocator
+{
+	typedef T value_type;
+	accountedAllocator() : account(NULL) {}
+	accountedAllocator(MemoryAccount* account) : account(account) {}
+	template <class U>
+	accountedAllocator(const accountedAllocator<U>& other) : account(other.account) {}
+	T* allocate(size_t count)
+	{
+		if (account == NULL)
+			return (T*)::operator new(count * sizeof(T));
+		return (T*)account->allocate(count * sizeof(T));
+	}
+	void deallocate(T* block, size_t count)
+	{
+		if (account == NULL)
+			::operator delete(block);
+		else
+			account->release(block, count * sizeof(T));
+	}
+	MemoryAccount* account;
+};
+
+//allocators are equal when they use the same account
+template <class T, class U>
+bool operator==(const accountedAllocator<T>& a, const accountedAllocator<U>& b)
+{
+	return a.account == b.account;
+}
+template <class T, class U>
+bool operator!=(const accountedAllocator<T>& a, const accountedAllocator<U>& b)
+{
+	return a.account != b.account;
+}
+
+//a string whose characters are allocated through an account
+typedef basic_string<char, char_traits<char>, accountedAllocator<char> > accountedString;
+
+//a vector whose elements are allocated through an account
+template <class T>
+using accountedVector = vector<T, accountedAllocator<T> >;
+#endif // !MEMORY_H
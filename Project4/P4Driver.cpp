@@ -5,18 +5,118 @@
 *	Programmer:  		Jeremy Atkins
 *
 *   Driver file that creates a huffman tree and allows the user options to encode, decode, print
-*	the tree, or print the code values.
+*	the tree, print the code values, decode part of a file from its checkpoints, append
+*	to an encoded file, sample the input when building the tree, use the built-in English
+*	code table, convert encoded files to packed files, archive many files in one, extract
+*	them again and search them, profile the phases of coding with the hardware counters, or
+*	show the memory coding takes and set a budget for it. Run as huffman -c or huffman -d,
+*	it instead codes standard input onto standard output, or decodes it, so it can sit in a
+*	pipeline, and huffman -t file checks that a file comes back through both of its coders.
+*	Run as huffman -s socket, it serves coding requests from other processes, which
+*	huffman -q socket sends.
 *
 *   Date Last Revised:	3/14/2019
 ****************************************************************************************************/
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <new>
 #include "Huffman.h"
+#include "Archive.h"
+#include "Stream.h"
+#include "Server.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 using namespace std;
 
-int main()
+int main(int argc, char* argv[])
 {
+	//pipeline mode codes standard input onto standard output
+	if (argc > 1 && (strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "-d") == 0))
+	{
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		bool ok = (argv[1][1] == 'c') ? compressStream(stdin, stdout) : decompressStream(stdin, stdout);
+		return ok ? 0 : 1;
+	}
+
+	//check mode, huffman -t file, round trips the file through the stream's coders
+	if (argc > 2 && strcmp(argv[1], "-t") == 0)
+	{
+		FILE* in = fopen(argv[2], "rb");
+		if (in == NULL)
+		{
+			cout << "Error opening " << argv[2] << endl;
+			return 1;
+		}
+		bool ok = checkStream(in);
+		fclose(in);
+		return ok ? 0 : 1;
+	}
+
+	//server mode, huffman -s socket [workers]
+	if (argc > 2 && strcmp(argv[1], "-s") == 0)
+	{
+		Server server(argv[2], (argc > 3) ? atoi(argv[3]) : (int)thread::hardware_concurrency());
+		return server.run() ? 0 : 1;
+	}
+
+	//one request to a server, huffman -q socket train|encode|decode|stats|stop [model],
+	//with the payload read from standard input and the reply written to standard output
+	if (argc > 3 && strcmp(argv[1], "-q") == 0)
+	{
+		const char* ops[] = { "train", "encode", "decode", "stats", "stop" };
+		const char codes[] = { SERVER_TRAIN, SERVER_ENCODE, SERVER_DECODE, SERVER_STATS, SERVER_STOP };
+		int op = 0;
+		while (op < 5 && strcmp(argv[3], ops[op]) != 0)
+			op++;
+		if (op == 5)
+		{
+			cerr << "Unknown request " << argv[3] << endl;
+			return 1;
+		}
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		vector<unsigned char> payload;
+		vector<unsigned char> reply;
+		if (op < 3)
+		{
+			char buffer[65536];
+			size_t got;
+			while ((got = fread(buffer, 1, sizeof(buffer), stdin)) > 0)
+				payload.insert(payload.end(), buffer, buffer + got);
+		}
+		if (!serverRequest(argv[2], codes[op], (argc > 4) ? argv[4] : "", payload, reply))
+			return 1;
+		if (!reply.empty())
+			fwrite(reply.data(), 1, reply.size(), stdout);
+		return 0;
+	}
+
 	Huffman huff;		//huffman tree
+	Archive archive;	//archive of many files
+	vector<string> members;	//files to archive
+	string memberName;	//file to extract from an archive, or text to search for
+	vector<archiveMatch> matches;	//where the text is in an archive
+	string outName;		//file to extract it to
+	char answer;		//yes or no
 	int choice;			//input
+	string fileName;	//file for partial decoding
+	unsigned offset;	//first character for partial decoding
+	unsigned length;	//number of characters for partial decoding
+	bool profiling = false;	//whether the hardware counters are read
+	size_t budget;		//memory budget in KB
+
+	//archives are counted against the same budget as the tree's buffers
+	archive.setMemoryAccount(&huff.memoryAccount());
 
 	do
 	{
@@ -26,6 +126,18 @@ int main()
 		cout << "3. Print the tree" << endl;
 		cout << "4. Print the code table" << endl;
 		cout << "5. Exit Program" << endl;
+		cout << "6. Set the checkpoint interval" << endl;
+		cout << "7. Decode part of a file" << endl;
+		cout << "8. Append a file to an encoded file" << endl;
+		cout << "9. Set the sampling stride" << endl;
+		cout << "10. Use the built-in English code table" << endl;
+		cout << "11. Convert encoded files to packed files" << endl;
+		cout << "12. Create an archive" << endl;
+		cout << "13. List an archive" << endl;
+		cout << "14. Extract a file from an archive" << endl;
+		cout << "15. Turn hardware counter profiling on or off" << endl;
+		cout << "16. Show the memory used and set the memory budget" << endl;
+		cout << "17. Search an archive" << endl;
 		cout << "Enter the number of the option to be selected: ";
 		cin >> choice;
 
@@ -34,12 +146,26 @@ int main()
 		{
 		//encode
 		case 1:
-			huff.encode();
+			try
+			{
+				huff.encode();
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
 			break;
 
 		//decode
 		case 2:
-			huff.decode();
+			try
+			{
+				huff.decode();
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
 			break;
 
 		//print the tree
@@ -57,6 +183,142 @@ int main()
 			cout << "Exitting Program" << endl;
 			break;
 
+		//set the checkpoint interval
+		case 6:
+			cout << "Enter the number of code bits between checkpoints (0 for none): ";
+			cin >> choice;
+			huff.setCheckpoints(choice);
+			choice = 6;
+			break;
+
+		//decode part of a file
+		case 7:
+			cout << "Enter the name of the file you would like to decode: ";
+			cin >> fileName;
+			cout << "Enter the first character and the number of characters to decode: ";
+			cin >> offset >> length;
+			cout << "\n\nMessage Decoded: " << endl;
+			cout << huff.decodeRange(fileName, offset, length) << endl;
+			break;
+
+		//append a file to an encoded file
+		case 8:
+			try
+			{
+				huff.append();
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
+			break;
+
+		//set the sampling stride
+		case 9:
+			cout << "Enter how many blocks of text to count one of (1 for all): ";
+			cin >> choice;
+			huff.setSampleStride(choice);
+			choice = 9;
+			break;
+
+		//use the built-in English code table
+		case 10:
+			huff.useFixedTable();
+			break;
+
+		//convert encoded files to packed files
+		case 11:
+			huff.convert();
+			break;
+
+		//create an archive
+		case 12:
+			cout << "Enter the name of the archive: ";
+			cin >> fileName;
+			cout << "Share one code table between the files (y/n): ";
+			cin >> answer;
+			archive.setSharedTable(answer == 'y' || answer == 'Y');
+			cout << "Enter the files to archive, ending with *: ";
+			members.clear();
+			while (cin >> memberName && memberName != "*")
+				members.push_back(memberName);
+			try
+			{
+				archive.create(fileName, members);
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
+			break;
+
+		//list an archive
+		case 13:
+			cout << "Enter the name of the archive: ";
+			cin >> fileName;
+			try
+			{
+				archive.list(fileName);
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
+			break;
+
+		//extract a file from an archive
+		case 14:
+			cout << "Enter the name of the archive: ";
+			cin >> fileName;
+			cout << "Enter the file to extract and the file to write it to: ";
+			cin >> memberName >> outName;
+			try
+			{
+				archive.extract(fileName, memberName, outName);
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
+			break;
+
+		//turn profiling on, or print the profile and turn it off
+		case 15:
+			profiling = !profiling;
+			if (!profiling)
+				huff.printProfile();
+			huff.setProfiling(profiling);
+			break;
+
+		//print the memory used, then set the most the buffers may take
+		case 16:
+			huff.printMemory();
+			cout << "Enter the memory budget in KB (0 for none): ";
+			cin >> budget;
+			huff.setMemoryBudget(budget * 1024);
+			break;
+
+		//search the members of an archive for a text
+		case 17:
+			cout << "Enter the name of the archive: ";
+			cin >> fileName;
+			cout << "Enter the text to search for: ";
+			cin >> memberName;
+			try
+			{
+				if (archive.search(fileName, memberName, matches))
+				{
+					for (size_t i = 0; i < matches.size(); i++)
+						cout << matches[i].member << ": " << matches[i].position << endl;
+					cout << matches.size() << " matches" << endl;
+				}
+			}
+			catch (const bad_alloc&)
+			{
+				cout << "Out of memory, or over the memory budget" << endl;
+			}
+			break;
+
 		//default
 		default:
 			break;
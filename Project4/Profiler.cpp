@@ -0,0 +1,265 @@
+/**************************************************************************************************
+*
+*   File name :			Profiler.cpp
+*
+*	Implementation of the Profiler class as defined in Profiler.h. The counters count the
+*	calling thread in user mode only. When the kernel has more counters open than the
+*	processor has, it takes turns between them, and each count is scaled up by the time it
+*	was enabled over the time it was counting.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#include "Profiler.h"
+#include <iomanip>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+//names of the counters in the report
+static const char* COUNTER_NAMES[PROFILE_COUNTERS] = { "cycles", "instructions", "branch misses",
+	"L1 data misses", "LLC misses" };
+
+#ifdef __linux__
+
+//opens one counter of the calling thread, returning -1 if it is not available
+static int openCounter(unsigned type, unsigned long long config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+//the config of a cache counter for read misses
+static unsigned long long cacheMisses(unsigned long long cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+#endif
+
+/*******************************************************************************************
+*	Function Name:			Profiler			the constructor
+*	Purpose:				Creates a profiler with no counters open and empty totals
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+Profiler::Profiler()
+{
+	for (int c = 0; c < PROFILE_COUNTERS; c++)
+		counters[c] = -1;
+	active = false;
+	current = -1;
+	nested = 0;
+	reset();
+}
+
+/*******************************************************************************************
+*	Function Name:			~Profiler			the destructor
+*	Purpose:				Closes the counters
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+Profiler::~Profiler()
+{
+	disable();
+}
+
+/*******************************************************************************************
+*	Function Name:			enable
+*	Purpose:				Opens the hardware counters and starts profiling. Phases are
+*							timed even when no counter could be opened
+*	Input Parameters:		none
+*	Return value:			bool				false if no counter could be opened
+********************************************************************************************/
+bool Profiler::enable()
+{
+	disable();
+	active = true;
+	bool opened = false;
+#ifdef __linux__
+	counters[COUNT_CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	counters[COUNT_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	counters[COUNT_BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	counters[COUNT_L1_MISSES] = openCounter(PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_L1D));
+	counters[COUNT_LLC_MISSES] = openCounter(PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_LL));
+	for (int c = 0; c < PROFILE_COUNTERS; c++)
+		opened = opened || counters[c] >= 0;
+#endif
+	return opened;
+}
+
+/*******************************************************************************************
+*	Function Name:			disable
+*	Purpose:				Stops profiling and closes the counters, keeping the totals
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Profiler::disable()
+{
+	for (int c = 0; c < PROFILE_COUNTERS; c++)
+	{
+#ifdef __linux__
+		if (counters[c] >= 0)
+			close(counters[c]);
+#endif
+		counters[c] = -1;
+	}
+	active = false;
+	current = -1;
+	nested = 0;
+}
+
+/*******************************************************************************************
+*	Function Name:			enabled
+*	Purpose:				Returns whether profiling is on
+*	Input Parameters:		none
+*	Return value:			bool				true after enable until disable
+********************************************************************************************/
+bool Profiler::enabled() const
+{
+	return active;
+}
+
+/*******************************************************************************************
+*	Function Name:			reset
+*	Purpose:				Clears every phase's totals
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Profiler::reset()
+{
+	memset(totals, 0, sizeof(totals));
+}
+
+/*******************************************************************************************
+*	Function Name:			begin
+*	Purpose:				Starts a phase, reading each counter. A phase begun while
+*							another is running is left in the running one's counts
+*	Input Parameters:		profilePhase phase	the phase starting
+*	Return value:			none
+********************************************************************************************/
+void Profiler::begin(profilePhase phase)
+{
+	if (!active)
+		return;
+	if (current >= 0)
+	{
+		nested++;
+		return;
+	}
+	current = phase;
+	for (int c = 0; c < PROFILE_COUNTERS; c++)
+		readCounter(c, start[c], startEnabled[c], startRunning[c]);
+	startTime = chrono::steady_clock::now();
+}
+
+/*******************************************************************************************
+*	Function Name:			end
+*	Purpose:				Ends the phase begun, adding its time and counts, scaled for
+*							the time each counter was counting, to the phase's totals
+*	Input Parameters:		size_t bytes		the text the phase worked on
+*	Return value:			none
+********************************************************************************************/
+void Profiler::end(size_t bytes)
+{
+	if (!active || current < 0)
+		return;
+	if (nested > 0)
+	{
+		nested--;
+		return;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+	phaseTotals& phase = totals[current];
+	for (int c = 0; c < PROFILE_COUNTERS; c++)
+	{
+		unsigned long long value, timeEnabled, timeRunning;
+		if (!readCounter(c, value, timeEnabled, timeRunning) || timeRunning <= startRunning[c])
+			continue;
+		phase.counts[c] += (double)(value - start[c]) * (double)(timeEnabled - startEnabled[c])
+			/ (double)(timeRunning - startRunning[c]);
+	}
+	phase.runs++;
+	phase.bytes += bytes;
+	phase.seconds += seconds;
+	current = -1;
+}
+
+/*******************************************************************************************
+*	Function Name:			report
+*	Purpose:				Prints each phase that has run: its runs, text and time, then
+*							each counter per MB of text, with instructions per cycle
+*	Input Parameters:		ostream out			where to print
+*	Return value:			none
+********************************************************************************************/
+void Profiler::report(ostream& out) const
+{
+	bool counted[PROFILE_COUNTERS];
+	for (int c = 0; c < PROFILE_COUNTERS; c++)
+		counted[c] = counters[c] >= 0;
+	for (int p = 0; p < PROFILE_PHASES; p++)
+	{
+		const phaseTotals& phase = totals[p];
+		if (phase.runs == 0)
+			continue;
+		double megabytes = phase.bytes / 1048576.0;
+		out << PHASE_NAMES[p] << ": " << phase.runs << " runs, " << phase.bytes << " bytes, "
+			<< fixed << setprecision(3) << phase.seconds * 1000 << " ms";
+		if (phase.seconds > 0)
+			out << ", " << setprecision(1) << megabytes / phase.seconds << " MB/s";
+		out << endl;
+		for (int c = 0; c < PROFILE_COUNTERS; c++)
+		{
+			out << "    " << setw(16) << left << COUNTER_NAMES[c] << right;
+			if (!counted[c])
+				out << "not available" << endl;
+			else if (megabytes > 0)
+				out << setprecision(0) << phase.counts[c] / megabytes << " per MB" << endl;
+			else
+				out << setprecision(0) << phase.counts[c] << endl;
+		}
+		if (counted[COUNT_CYCLES] && counted[COUNT_INSTRUCTIONS] && phase.counts[COUNT_CYCLES] > 0)
+			out << "    " << setw(16) << left << "per cycle" << right << setprecision(2)
+				<< phase.counts[COUNT_INSTRUCTIONS] / phase.counts[COUNT_CYCLES] << " instructions" << endl;
+	}
+	out.unsetf(ios::floatfield);
+	out << setprecision(6);
+}
+
+/*******************************************************************************************
+*	Function Name:			readCounter
+*	Purpose:				Reads a counter's value, the time it has been enabled and the
+*							time it has been counting
+*	Input Parameters:		int counter					the counter
+*							unsigned long long value		its count
+*							unsigned long long timeEnabled	its time enabled
+*							unsigned long long timeRunning	its time counting
+*	Return value:			bool						false if the counter is not open
+********************************************************************************************/
+bool Profiler::readCounter(int counter, unsigned long long& value, unsigned long long& timeEnabled,
+	unsigned long long& timeRunning) const
+{
+	value = timeEnabled = timeRunning = 0;
+#ifdef __linux__
+	unsigned long long reading[3];
+	if (counters[counter] < 0 || read(counters[counter], reading, sizeof(reading)) != sizeof(reading))
+		return false;
+	value = reading[0];
+	timeEnabled = reading[1];
+	timeRunning = reading[2];
+	return true;
+#else
+	(void)counter;
+	return false;
+#endif
+}
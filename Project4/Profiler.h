@@ -0,0 +1,121 @@
+/**************************************************************************************************
+*
+*   File name :			Profiler.h
+*
+*   Header file for the Profiler class, implemented in Profiler.cpp, which counts what the
+*	processor does during each phase of coding: cycles, instructions, branch misses and level 1
+*	data and last level cache misses, read from the hardware counters through Linux's
+*	perf_event_open. Each phase's counts are added up over its runs and reported per MB of
+*	text, so a change to a loop can be checked for what it does to mispredicts or misses and
+*	not only to the time it takes.
+*
+*	Profiling is off until enable is called. A counter the processor or kernel does not give,
+*	as on other platforms or in many virtual machines, is reported as not available, and the
+*	phases are still timed.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		Profiler
+*
+*	Structs:
+*		phaseTotals					the runs, text, time and counts of one phase
+*		profileScope				profiles a phase for as long as it is in scope
+*
+*	Private data members:
+*		int counters[]				the open counters, -1 for one that could not be opened
+*		bool active					whether enable has been called
+*		int current					the phase running, -1 for none
+*		int nested					phases begun inside the running one, which are not counted
+*		unsigned long long start[]	each counter's reading when the phase began
+*		unsigned long long startEnabled[]	each counter's time enabled when the phase began
+*		unsigned long long startRunning[]	each counter's time counting when the phase began
+*		chrono::steady_clock::time_point startTime	when the phase began
+*		phaseTotals totals[]		each phase's totals
+*
+*	Private member functions:
+*		bool readCounter			reads a counter's value and times
+*
+*	Public member functions:
+*		Profiler			constructor for a profiler that is off
+*		~Profiler			destructor closing the counters
+*		bool enable			opens the counters and starts profiling
+*		void disable		stops profiling and closes the counters
+*		bool enabled		whether profiling is on
+*		void reset			clears the totals
+*		void begin			starts a phase
+*		void end			ends the phase begun, adding its counts to the totals
+*		void report			prints each phase's totals per MB
+*
+****************************************************************************************************/
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <iostream>
+#include <chrono>
+using namespace std;
+
+//the phases of coding that are profiled
+enum profilePhase { PHASE_READ, PHASE_HISTOGRAM, PHASE_BUILD, PHASE_ENCODE, PHASE_DECODE,
+	PROFILE_PHASES };
+const char* const PHASE_NAMES[PROFILE_PHASES] = { "read", "histogram", "build", "encode", "decode" };
+
+//the hardware counters read for each phase
+enum profileCounter { COUNT_CYCLES, COUNT_INSTRUCTIONS, COUNT_BRANCH_MISSES, COUNT_L1_MISSES,
+	COUNT_LLC_MISSES, PROFILE_COUNTERS };
+
+//phaseTotals struct adding up the runs of one phase
+struct phaseTotals
+{
+	unsigned long long runs;
+	unsigned long long bytes;
+	double seconds;
+	double counts[PROFILE_COUNTERS];
+};
+
+//profiler class reading the hardware counters around each phase
+class Profiler
+{
+public:
+	Profiler();
+	~Profiler();
+	bool enable();
+	void disable();
+	bool enabled() const;
+	void reset();
+	void begin(profilePhase phase);
+	void end(size_t bytes);
+	void report(ostream& out) const;
+
+private:
+	bool readCounter(int counter, unsigned long long& value, unsigned long long& timeEnabled,
+		unsigned long long& timeRunning) const;
+	int counters[PROFILE_COUNTERS];
+	bool active;
+	int current;
+	int nested;
+	unsigned long long start[PROFILE_COUNTERS];
+	unsigned long long startEnabled[PROFILE_COUNTERS];
+	unsigned long long startRunning[PROFILE_COUNTERS];
+	chrono::steady_clock::time_point startTime;
+	phaseTotals totals[PROFILE_PHASES];
+};
+
+//profileScope struct profiling a phase from its construction to its destruction,
+//so every return from the phase ends it; does nothing while profiling is off.
+//bytes may be changed before the end when the text's size is only known then
+struct profileScope
+{
+	profileScope(Profiler& profiler, profilePhase phase, size_t bytes)
+		: profiler(profiler), bytes(bytes)
+	{
+		if (profiler.enabled())
+			profiler.begin(phase);
+	}
+	~profileScope()
+	{
+		if (profiler.enabled())
+			profiler.end(bytes);
+	}
+	Profiler& profiler;
+	size_t bytes;
+};
+#endif // !PROFILER_H
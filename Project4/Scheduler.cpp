@@ -0,0 +1,211 @@
+/**************************************************************************************************
+*
+*   File name :			Scheduler.cpp
+*
+*	Implementation of the Scheduler class as defined in Scheduler.h.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#include "Scheduler.h"
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+
+//the index of the worker running on this thread, -1 on threads outside the pool
+static thread_local int workerIndex = -1;
+
+/*******************************************************************************************
+*	Function Name:			Scheduler			the constructor
+*	Purpose:				Starts the workers, each with an empty deque
+*	Input Parameters:		int workers			the number of workers, at least 1
+*							bool pinned			whether to pin each worker to one core,
+*												which keeps its buffers in that core's
+*												caches and, on NUMA machines, its memory
+*	Return value:			none
+********************************************************************************************/
+Scheduler::Scheduler(int workers, bool pinned)
+	: queued(0), unfinished(0), nextQueue(0)
+{
+	stopping = false;
+	this->pinned = pinned;
+	workers = max(1, workers);
+	for (int w = 0; w < workers; w++)
+		queues.push_back(unique_ptr<taskQueue>(new taskQueue));
+	for (int w = 0; w < workers; w++)
+		threads.push_back(thread(&Scheduler::work, this, w));
+}
+
+/*******************************************************************************************
+*	Function Name:			~Scheduler			the destructor
+*	Purpose:				Waits for the tasks still queued, then stops the workers
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+Scheduler::~Scheduler()
+{
+	wait();
+	{
+		lock_guard<mutex> guard(idleLock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (size_t w = 0; w < threads.size(); w++)
+		threads[w].join();
+}
+
+/*******************************************************************************************
+*	Function Name:			submit
+*	Purpose:				Adds a task, onto the calling worker's own deque when called
+*							from a task, or onto the deques in turn from outside the pool
+*	Input Parameters:		function task		the task to run
+*	Return value:			none
+********************************************************************************************/
+void Scheduler::submit(function<void()> task)
+{
+	int index = workerIndex;
+	if (index < 0)
+		index = (int)(nextQueue++ % queues.size());
+	unfinished++;
+	{
+		lock_guard<mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(move(task));
+	}
+
+	//counted under the idle lock so a worker about to sleep cannot miss it
+	{
+		lock_guard<mutex> guard(idleLock);
+		queued++;
+	}
+	wake.notify_one();
+}
+
+/*******************************************************************************************
+*	Function Name:			wait
+*	Purpose:				Blocks until every task submitted so far, and every task those
+*							submitted, has finished
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Scheduler::wait()
+{
+	unique_lock<mutex> guard(idleLock);
+	done.wait(guard, [this]() { return unfinished == 0; });
+}
+
+/*******************************************************************************************
+*	Function Name:			size
+*	Purpose:				Returns the number of workers
+*	Input Parameters:		none
+*	Return value:			int					the number of workers
+********************************************************************************************/
+int Scheduler::size() const
+{
+	return (int)threads.size();
+}
+
+/*******************************************************************************************
+*	Function Name:			current
+*	Purpose:				Returns the index of the worker calling it, so a task can use
+*							per-worker state without locking
+*	Input Parameters:		none
+*	Return value:			int					the worker's index, -1 off the pool
+********************************************************************************************/
+int Scheduler::current()
+{
+	return workerIndex;
+}
+
+/*******************************************************************************************
+*	Function Name:			work
+*	Purpose:				A worker's loop, running tasks while there are any and sleeping
+*							when every deque is empty
+*	Input Parameters:		int index			the worker's index
+*	Return value:			none
+********************************************************************************************/
+void Scheduler::work(int index)
+{
+	workerIndex = index;
+	if (pinned)
+		pin(index);
+	function<void()> task;
+	while (true)
+	{
+		if (take(index, task))
+		{
+			task();
+			task = nullptr;
+
+			//the last task to finish wakes wait, under the lock so wait cannot miss it
+			if (--unfinished == 0)
+			{
+				lock_guard<mutex> guard(idleLock);
+				done.notify_all();
+			}
+			continue;
+		}
+		unique_lock<mutex> guard(idleLock);
+		wake.wait(guard, [this]() { return stopping || queued > 0; });
+		if (stopping && queued == 0)
+			return;
+	}
+}
+
+/*******************************************************************************************
+*	Function Name:			take
+*	Purpose:				Takes the newest task from the worker's own deque, or else the
+*							oldest task from the next deque that has one, oldest because
+*							it is the likeliest to split into more work
+*	Input Parameters:		int index			the worker's index
+*							function task		the task taken
+*	Return value:			bool				false if every deque is empty
+********************************************************************************************/
+bool Scheduler::take(int index, function<void()>& task)
+{
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		taskQueue& queue = *queues[(index + i) % queues.size()];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.tasks.empty())
+			continue;
+		if (i == 0)
+		{
+			task = move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+/*******************************************************************************************
+*	Function Name:			pin
+*	Purpose:				Pins the calling worker to one core, spreading the workers over
+*							the cores in turn; does nothing where it is not supported
+*	Input Parameters:		int index			the worker's index
+*	Return value:			none
+********************************************************************************************/
+void Scheduler::pin(int index)
+{
+	unsigned cores = max(1u, thread::hardware_concurrency());
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (index % cores % (8 * sizeof(DWORD_PTR))));
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(index % cores, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void)index;
+	(void)cores;
+#endif
+}
@@ -0,0 +1,93 @@
+/**************************************************************************************************
+*
+*   File name :			Scheduler.h
+*
+*   Header file for the Scheduler class, implemented in Scheduler.cpp, a pool of worker threads
+*	that share out tasks by work stealing. Each worker has its own deque: a task submitted from
+*	a worker goes on that worker's deque, which it runs newest first, and a worker with nothing
+*	left takes the oldest task from another worker's deque. A big job that splits itself into
+*	smaller tasks so spreads over idle workers without a fixed split up front, while many small
+*	jobs stay on the workers that made them.
+*
+*	Tasks may finish in any order, so a task that produces output writes it into a slot of its
+*	own, and the caller puts the slots in order after wait.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		Scheduler
+*
+*	Structs:
+*		taskQueue					one worker's deque of tasks and its lock
+*
+*	Private data members:
+*		vector<unique_ptr<taskQueue>> queues	each worker's tasks
+*		vector<thread> threads		the workers
+*		mutex idleLock				guards waiting for tasks and for the pool to empty
+*		condition_variable wake		wakes idle workers when a task is submitted
+*		condition_variable done		wakes wait when the last task finishes
+*		atomic<size_t> queued		tasks in the deques
+*		atomic<size_t> unfinished	tasks submitted and not yet finished
+*		atomic<unsigned> nextQueue	the deque the next outside submission goes on
+*		bool stopping				set when the scheduler is destroyed
+*		bool pinned					whether each worker is pinned to one core
+*
+*	Private member functions:
+*		void work					a worker's loop
+*		bool take					pops a task from a worker's deque or steals one
+*		void pin					pins the calling worker to a core
+*
+*	Public member functions:
+*		Scheduler			constructor starting the workers
+*		~Scheduler			destructor finishing the tasks and stopping the workers
+*		void submit			adds a task
+*		void wait			waits until every submitted task has finished
+*		int size			the number of workers
+*		int current			the index of the calling worker, -1 off the pool
+*
+****************************************************************************************************/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+using namespace std;
+
+//taskQueue struct holding one worker's tasks
+struct taskQueue
+{
+	mutex lock;
+	deque<function<void()> > tasks;
+};
+
+//scheduler class for running tasks on a work stealing pool
+class Scheduler
+{
+public:
+	Scheduler(int workers, bool pinned = false);
+	~Scheduler();
+	void submit(function<void()> task);
+	void wait();
+	int size() const;
+	static int current();
+
+private:
+	void work(int index);
+	bool take(int index, function<void()>& task);
+	void pin(int index);
+	vector<unique_ptr<taskQueue> > queues;
+	vector<thread> threads;
+	mutex idleLock;
+	condition_variable wake;
+	condition_variable done;
+	atomic<size_t> queued;
+	atomic<size_t> unfinished;
+	atomic<unsigned> nextQueue;
+	bool stopping;
+	bool pinned;
+};
+#endif // !SCHEDULER_H
@@ -0,0 +1,846 @@
+/**************************************************************************************************
+*
+*   File name :			Server.cpp
+*
+*	Implementation of the Server class as defined in Server.h, on POSIX sockets. Messages go
+*	to standard error, since a client's standard output may be carrying code.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#include "Server.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+//smallest payload a client passes in a memfd rather than on the socket
+const size_t SERVER_SHARED_MIN = 1 << 16;
+
+//most memfds taken from one read of a connection
+const int SERVER_MAX_PASSED = 8;
+
+//status bytes of a reply
+const unsigned char SERVER_DONE = 0;
+const unsigned char SERVER_ERROR = 1;
+
+#ifndef _WIN32
+
+//reads exactly size bytes, returns false if the connection closes first
+static bool readFull(int fd, void* data, size_t size)
+{
+	char* at = (char*)data;
+	while (size > 0)
+	{
+		ssize_t got = read(fd, at, size);
+		if (got <= 0)
+			return false;
+		at += got;
+		size -= (size_t)got;
+	}
+	return true;
+}
+
+//writes exactly size bytes, waiting while a non-blocking connection is full,
+//returns false if the connection closes first
+static bool writeFull(int fd, const void* data, size_t size)
+{
+	const char* at = (const char*)data;
+	while (size > 0)
+	{
+		ssize_t put = write(fd, at, size);
+		if (put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			pollfd room = { fd, POLLOUT, 0 };
+			poll(&room, 1, -1);
+			continue;
+		}
+		if (put <= 0)
+			return false;
+		at += put;
+		size -= (size_t)put;
+	}
+	return true;
+}
+
+//puts a number as 4 bytes, least significant first
+static void putWord(unsigned char* at, size_t value)
+{
+	for (int b = 0; b < 4; b++)
+		at[b] = (unsigned char)(value >> (8 * b));
+}
+
+//gets a number put by putWord
+static size_t getWord(const unsigned char* at)
+{
+	size_t value = 0;
+	for (int b = 0; b < 4; b++)
+		value |= (size_t)at[b] << (8 * b);
+	return value;
+}
+
+//writes a reply of a status and a payload
+static bool reply(int fd, unsigned char status, const void* data, size_t size)
+{
+	unsigned char header[5];
+	header[0] = status;
+	putWord(header + 1, size);
+	return writeFull(fd, header, 5) && writeFull(fd, data, size);
+}
+
+//adds the descriptors passed with a message onto the end of passed
+static void takeDescriptors(msghdr& message, deque<int>& passed)
+{
+	for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != NULL; header = CMSG_NXTHDR(&message, header))
+	{
+		if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+			continue;
+		size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (size_t d = 0; d < count; d++)
+		{
+			int fd;
+			memcpy(&fd, CMSG_DATA(header) + d * sizeof(int), sizeof(int));
+			passed.push_back(fd);
+		}
+	}
+}
+
+//reads exactly size bytes like readFull, adding any descriptors passed with them to passed
+static bool readPassing(int fd, void* data, size_t size, deque<int>& passed)
+{
+	char* at = (char*)data;
+	while (size > 0)
+	{
+		char control[CMSG_SPACE(SERVER_MAX_PASSED * sizeof(int))];
+		iovec part = { at, size };
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = &part;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		ssize_t got = recvmsg(fd, &message, 0);
+		if (got <= 0)
+			return false;
+		takeDescriptors(message, passed);
+		at += got;
+		size -= (size_t)got;
+	}
+	return true;
+}
+
+//writes exactly size bytes like writeFull, passing a descriptor along with the first of them
+static bool writePassing(int fd, const void* data, size_t size, int passed)
+{
+	char control[CMSG_SPACE(sizeof(int))];
+	memset(control, 0, sizeof(control));
+	iovec part = { (void*)data, size };
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &part;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	cmsghdr* header = CMSG_FIRSTHDR(&message);
+	header->cmsg_level = SOL_SOCKET;
+	header->cmsg_type = SCM_RIGHTS;
+	header->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(header), &passed, sizeof(int));
+	while (true)
+	{
+		ssize_t put = sendmsg(fd, &message, 0);
+		if (put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			pollfd room = { fd, POLLOUT, 0 };
+			poll(&room, 1, -1);
+			continue;
+		}
+		if (put <= 0)
+			return false;
+		return writeFull(fd, (const char*)data + put, size - (size_t)put);
+	}
+}
+
+//makes a memfd of the given size and maps it for writing, storing it in fd,
+//returns NULL if it could not be made, as everywhere but Linux
+static unsigned char* sharedArea(size_t size, int& fd)
+{
+	fd = -1;
+#ifdef __linux__
+	fd = memfd_create("huffman", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0)
+		return NULL;
+	void* area = (ftruncate(fd, (off_t)max(size, (size_t)1)) == 0)
+		? mmap(NULL, max(size, (size_t)1), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	if (area != MAP_FAILED)
+		return (unsigned char*)area;
+	close(fd);
+	fd = -1;
+#else
+	(void)size;
+#endif
+	return NULL;
+}
+
+//unmaps a memfd made by sharedArea, cuts it to the bytes used and seals it so the
+//reader can map it without its size changing underneath, returns false on failure
+static bool sealArea(unsigned char* area, size_t size, int fd, size_t used)
+{
+#ifdef __linux__
+	munmap(area, max(size, (size_t)1));
+	return ftruncate(fd, (off_t)used) == 0
+		&& fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+#else
+	(void)area;
+	(void)size;
+	(void)fd;
+	(void)used;
+	return false;
+#endif
+}
+
+//maps the first size bytes of a passed memfd for reading, returns NULL unless it holds
+//them and is sealed against shrinking, which would fault the reader
+static const unsigned char* mapShared(int fd, size_t size)
+{
+#ifdef __linux__
+	struct stat info;
+	int seals = fcntl(fd, F_GET_SEALS);
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < size || seals < 0 || !(seals & F_SEAL_SHRINK))
+		return NULL;
+	void* area = mmap(NULL, max(size, (size_t)1), PROT_READ, MAP_SHARED, fd, 0);
+	return (area == MAP_FAILED) ? NULL : (const unsigned char*)area;
+#else
+	(void)fd;
+	(void)size;
+	return NULL;
+#endif
+}
+
+//makes reads and writes on a descriptor return at once rather than wait
+static bool setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+//fills in the address of a socket path, returns false if the path is too long
+static bool socketAddress(const string& socketPath, sockaddr_un& address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path))
+	{
+		cerr << "The socket path " << socketPath << " is too long" << endl;
+		return false;
+	}
+	memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+	return true;
+}
+
+#endif
+
+/*******************************************************************************************
+*	Function Name:			Server				the constructor
+*	Purpose:				Creates a server with no models for a socket path
+*	Input Parameters:		string socketPath	the socket to listen on
+*							int workers			the threads serving requests, at least 1
+*	Return value:			none
+********************************************************************************************/
+Server::Server(const string& socketPath, int workers)
+{
+	this->socketPath = socketPath;
+	this->workers = max(1, workers);
+	listener = -1;
+	wakeRead = -1;
+	wakeWrite = -1;
+	stopping = false;
+	served = 0;
+	failed = 0;
+	totalMicros = 0;
+	longestMicros = 0;
+	deepestQueue = 0;
+}
+
+/*******************************************************************************************
+*	Function Name:			run
+*	Purpose:				Listens on the socket and polls the open connections, queueing
+*							each request for the workers once it has arrived in full, until
+*							a client asks the server to stop; then lets the workers finish
+*							the requests already queued and closes every connection
+*	Input Parameters:		none
+*	Return value:			bool				false if the socket could not be set up
+********************************************************************************************/
+bool Server::run()
+{
+#ifdef _WIN32
+	cerr << "The server needs Unix domain sockets, which this platform does not have" << endl;
+	return false;
+#else
+	sockaddr_un address;
+	if (!socketAddress(socketPath, address))
+		return false;
+
+	//a client that goes away mid reply should not end the server
+	signal(SIGPIPE, SIG_IGN);
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath.c_str());
+	if (listener < 0 || ::bind(listener, (sockaddr*)&address, sizeof(address)) != 0
+		|| listen(listener, SOMAXCONN) != 0 || !setNonBlocking(listener))
+	{
+		cerr << "Error listening on " << socketPath << ": " << strerror(errno) << endl;
+		return false;
+	}
+	int wake[2];
+	if (pipe(wake) != 0 || !setNonBlocking(wake[0]) || !setNonBlocking(wake[1]))
+	{
+		cerr << "Error creating the wake pipe: " << strerror(errno) << endl;
+		return false;
+	}
+	wakeRead = wake[0];
+	wakeWrite = wake[1];
+	cerr << "Serving on " << socketPath << " with " << workers << " workers" << endl;
+
+	vector<thread> pool;
+	for (int w = 0; w < workers; w++)
+		pool.push_back(thread(&Server::work, this));
+	vector<pollfd> polled;
+	while (true)
+	{
+		//connections the workers are done with are polled again, or closed if they broke
+		{
+			lock_guard<mutex> guard(lock);
+			if (stopping)
+				break;
+			for (size_t f = 0; f < finished.size(); f++)
+			{
+				if (finished[f].second)
+					connections[finished[f].first].busy = false;
+				else
+					drop(finished[f].first);
+			}
+			finished.clear();
+		}
+
+		//a request that arrived behind the one just served is queued without waiting
+		for (map<int, serverConnection>::iterator at = connections.begin(); at != connections.end();)
+		{
+			int client = at->first;
+			bool open = dispatch(client, at->second);
+			++at;
+			if (!open)
+				drop(client);
+		}
+
+		polled.clear();
+		polled.push_back({ listener, POLLIN, 0 });
+		polled.push_back({ wakeRead, POLLIN, 0 });
+		for (map<int, serverConnection>::iterator at = connections.begin(); at != connections.end(); ++at)
+		{
+			if (!at->second.busy)
+				polled.push_back({ at->first, POLLIN, 0 });
+		}
+		if (poll(polled.data(), polled.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cerr << "Error polling the connections: " << strerror(errno) << endl;
+			lock_guard<mutex> guard(lock);
+			stopping = true;
+			break;
+		}
+		char drained[64];
+		while (read(wakeRead, drained, sizeof(drained)) > 0)
+		{
+		}
+		if (polled[0].revents & POLLIN)
+		{
+			int client;
+			while ((client = accept(listener, NULL, NULL)) >= 0)
+			{
+				if (setNonBlocking(client))
+					connections[client].busy = false;
+				else
+					close(client);
+			}
+		}
+		for (size_t p = 2; p < polled.size(); p++)
+		{
+			if (polled[p].revents != 0 && !receive(polled[p].fd, connections[polled[p].fd]))
+				drop(polled[p].fd);
+		}
+	}
+
+	//wake the idle workers so they see the server is stopping
+	ready.notify_all();
+	for (size_t w = 0; w < pool.size(); w++)
+		pool[w].join();
+	while (!connections.empty())
+		drop(connections.begin()->first);
+	close(listener);
+	close(wakeRead);
+	close(wakeWrite);
+	unlink(socketPath.c_str());
+	cerr << stats();
+	return true;
+#endif
+}
+
+/*******************************************************************************************
+*	Function Name:			work
+*	Purpose:				A worker's loop, serving the oldest waiting request, then handing
+*							its connection back to the listening thread to be polled again
+*	Input Parameters:		none
+*	Return value:			none
+********************************************************************************************/
+void Server::work()
+{
+#ifndef _WIN32
+	while (true)
+	{
+		serverJob job;
+		{
+			unique_lock<mutex> guard(lock);
+			ready.wait(guard, [this]() { return stopping || !waiting.empty(); });
+			if (waiting.empty())
+				return;
+			job = move(waiting.front());
+			waiting.pop_front();
+		}
+		bool open = serve(job);
+		{
+			lock_guard<mutex> guard(lock);
+			finished.push_back(make_pair(job.client, open));
+		}
+
+		//a full pipe already holds a wake up, so a failed write loses nothing
+		char wake = 0;
+		if (write(wakeWrite, &wake, 1) < 0)
+		{
+		}
+	}
+#endif
+}
+
+/*******************************************************************************************
+*	Function Name:			receive
+*	Purpose:				Reads what a connection has sent so far onto its received bytes,
+*							keeping any memfds passed with them
+*	Input Parameters:		int client					the connection
+*							serverConnection connection	its received bytes and memfds
+*	Return value:			bool						false once the client has closed it
+*														or it is broken
+********************************************************************************************/
+bool Server::receive(int client, serverConnection& connection)
+{
+#ifdef _WIN32
+	return false;
+#else
+	unsigned char buffer[65536];
+	char control[CMSG_SPACE(SERVER_MAX_PASSED * sizeof(int))];
+	iovec part = { buffer, sizeof(buffer) };
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &part;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	ssize_t got = recvmsg(client, &message, 0);
+	if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		return true;
+	if (got <= 0)
+		return false;
+	takeDescriptors(message, connection.shared);
+
+	//memfds the control buffer had no room for are lost, and with them their requests;
+	//a client passing more than its requests use is not let hold them open
+	if ((message.msg_flags & MSG_CTRUNC) || connection.shared.size() > SERVER_MAX_PASSED)
+		return false;
+	connection.received.insert(connection.received.end(), buffer, buffer + got);
+	return true;
+#endif
+}
+
+/*******************************************************************************************
+*	Function Name:			dispatch
+*	Purpose:				Queues the next request on a connection for the workers once
+*							all of it has arrived and no worker has the connection, with the
+*							memfd a shared request passed; a request announcing too large a
+*							payload, or shared without a memfd, is answered with an error here
+*	Input Parameters:		int client					the connection
+*							serverConnection connection	its received bytes
+*	Return value:			bool						false if the connection should close
+********************************************************************************************/
+bool Server::dispatch(int client, serverConnection& connection)
+{
+#ifdef _WIN32
+	return false;
+#else
+	//the op, the name's length and name, then the payload's length and payload
+	vector<unsigned char>& in = connection.received;
+	if (connection.busy || in.size() < 2 || in.size() < (size_t)6 + in[1])
+		return true;
+	size_t size = getWord(&in[2 + in[1]]);
+	if (size > SERVER_MAX_PAYLOAD)
+	{
+		string error = "The payload is larger than the server takes";
+		reply(client, SERVER_ERROR, error.data(), error.size());
+		return false;
+	}
+	bool shared = (in[0] & SERVER_SHARED) != 0;
+	if (shared && connection.shared.empty())
+	{
+		string error = "The request is shared but passed no memfd";
+		reply(client, SERVER_ERROR, error.data(), error.size());
+		return false;
+	}
+
+	//a shared payload is in the memfd, not on the socket
+	size_t length = 6 + in[1] + (shared ? 0 : size);
+	if (in.size() < length)
+		return true;
+	serverJob job;
+	job.client = client;
+	job.request.assign(in.begin(), in.begin() + length);
+	job.shared = -1;
+	if (shared)
+	{
+		job.shared = connection.shared.front();
+		connection.shared.pop_front();
+	}
+	in.erase(in.begin(), in.begin() + length);
+	connection.busy = true;
+
+	lock_guard<mutex> guard(lock);
+	waiting.push_back(move(job));
+	deepestQueue = max(deepestQueue, waiting.size());
+	ready.notify_one();
+	return true;
+#endif
+}
+
+/*******************************************************************************************
+*	Function Name:			serve
+*	Purpose:				Carries out one request with the named model and writes the
+*							reply, timing it for the statistics; a shared request's payload
+*							is mapped from its memfd, and its reply is written to a sealed
+*							memfd passed back rather than onto the socket
+*	Input Parameters:		serverJob job		the request, as dispatch found it
+*	Return value:			bool				false if the connection broke
+********************************************************************************************/
+bool Server::serve(const serverJob& job)
+{
+#ifdef _WIN32
+	(void)job;
+	return false;
+#else
+	auto begin = chrono::steady_clock::now();
+	const vector<unsigned char>& request = job.request;
+	char op = (char)(request[0] & ~SERVER_SHARED);
+	string name((const char*)&request[2], request[1]);
+	size_t size = getWord(&request[2 + name.size()]);
+	const unsigned char* payload = request.data() + 6 + name.size();
+	const unsigned char* mapped = NULL;
+	string error;
+	if (job.shared >= 0)
+	{
+		mapped = mapShared(job.shared, size);
+		if (mapped == NULL)
+			error = "The shared payload could not be mapped";
+		payload = mapped;
+	}
+
+	//the model is shared, so a request keeps it alive even if it is trained again meanwhile
+	shared_ptr<const byteCodec> model;
+	{
+		lock_guard<mutex> guard(lock);
+		map<string, shared_ptr<const byteCodec> >::iterator found = models.find(name);
+		if (found != models.end())
+			model = found->second;
+	}
+
+	//a shared request's reply goes to a memfd of the reply's exact size
+	vector<unsigned char> out;
+	unsigned char* area = NULL;
+	size_t areaSize = 0;
+	int replied = -1;
+	size_t used = 0;
+	if (!error.empty())
+	{
+		//the shared payload could not be mapped, so there is nothing to carry out
+	}
+	else if (op == SERVER_TRAIN)
+	{
+		shared_ptr<byteCodec> trained = make_shared<byteCodec>();
+		trained->count(payload, size);
+		if (!trained->build())
+			error = "The sample is empty";
+		else
+		{
+			lock_guard<mutex> guard(lock);
+			models[name] = trained;
+		}
+	}
+	else if (op == SERVER_ENCODE || op == SERVER_DECODE)
+	{
+		//the byte count and code bits, then the code, which is a decode request's payload;
+		//or the bytes a decode request's code stands for
+		size_t count = 0;
+		size_t bits = 0;
+		if (!model)
+			error = "There is no model named " + name;
+		else if (op == SERVER_ENCODE)
+		{
+			//checked first, since encode only returns 0 and the client is told which failure it was;
+			//the code can be several times the payload, so its size is also checked against what a
+			//client takes before any of it is written
+			size_t needed = 0;
+			for (size_t i = 0; i < size && error.empty(); i++)
+			{
+				size_t length = model->codeLength(payload[i]);
+				if (length == 0)
+					error = "The payload has a byte the model was not trained on";
+				needed += length;
+			}
+			if (error.empty() && 8 + (needed + 7) / 8 > SERVER_MAX_PAYLOAD)
+				error = "The code would be larger than the largest reply";
+			count = size;
+			used = 8 + (needed + 7) / 8;
+		}
+		else
+		{
+			count = (size >= 8) ? getWord(&payload[0]) : 0;
+			bits = (size >= 8) ? getWord(&payload[4]) : 0;
+			if (size < 8 || (bits + 7) / 8 > size - 8 || count > SERVER_MAX_PAYLOAD)
+				error = "The code is damaged";
+			used = count;
+		}
+
+		unsigned char* to = NULL;
+		if (error.empty() && job.shared >= 0)
+		{
+			areaSize = used;
+			area = sharedArea(areaSize, replied);
+			if (area == NULL)
+				error = "The reply could not be shared";
+			to = area;
+		}
+		else if (error.empty())
+		{
+			out.resize(used);
+			to = out.data();
+		}
+		if (error.empty() && op == SERVER_ENCODE)
+		{
+			bits = (size == 0) ? 0 : model->encode(payload, size, &to[8], used - 8);
+			if (bits == 0 && size > 0)
+				error = "The payload could not be coded";
+			putWord(&to[0], count);
+			putWord(&to[4], bits);
+		}
+		else if (error.empty() && count > 0 && model->decode(&payload[8], bits, to, count) != count)
+			error = "The code is damaged";
+	}
+	else if (op == SERVER_STATS)
+	{
+		string text = stats();
+		out.assign(text.begin(), text.end());
+	}
+	else if (op == SERVER_STOP)
+	{
+		//the listening thread sees it when this worker wakes it
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	else
+		error = "Unknown request";
+
+	if (area != NULL && error.empty())
+	{
+		if (!sealArea(area, areaSize, replied, used))
+			error = "The reply could not be shared";
+	}
+	else if (area != NULL)
+		munmap(area, max(areaSize, (size_t)1));
+
+	bool ok;
+	if (!error.empty())
+		ok = reply(job.client, SERVER_ERROR, error.data(), error.size());
+	else if (area != NULL)
+	{
+		//only the size is on the socket, the reply itself is in the memfd passed with it
+		unsigned char header[5];
+		header[0] = SERVER_DONE | SERVER_SHARED;
+		putWord(header + 1, used);
+		ok = writePassing(job.client, header, 5, replied);
+	}
+	else
+		ok = reply(job.client, SERVER_DONE, out.data(), out.size());
+	if (replied >= 0)
+		close(replied);
+	if (mapped != NULL)
+		munmap((void*)mapped, max(size, (size_t)1));
+	if (job.shared >= 0)
+		close(job.shared);
+
+	double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+	lock_guard<mutex> guard(lock);
+	served++;
+	if (!error.empty())
+		failed++;
+	totalMicros += micros;
+	longestMicros = max(longestMicros, micros);
+	return ok;
+#endif
+}
+
+/*******************************************************************************************
+*	Function Name:			drop
+*	Purpose:				Closes a connection along with the memfds it passed that no
+*							request has taken
+*	Input Parameters:		int client			the connection
+*	Return value:			none
+********************************************************************************************/
+void Server::drop(int client)
+{
+#ifndef _WIN32
+	map<int, serverConnection>::iterator found = connections.find(client);
+	if (found != connections.end())
+	{
+		for (size_t s = 0; s < found->second.shared.size(); s++)
+			close(found->second.shared[s]);
+		connections.erase(found);
+	}
+	close(client);
+#else
+	(void)client;
+#endif
+}
+
+/*******************************************************************************************
+*	Function Name:			stats
+*	Purpose:				Describes the models, queue and request times
+*	Input Parameters:		none
+*	Return value:			string				the statistics, a line each
+********************************************************************************************/
+string Server::stats()
+{
+	lock_guard<mutex> guard(lock);
+	ostringstream text;
+	text << "Models: " << models.size() << endl;
+	text << "Waiting requests: " << waiting.size() << " (most " << deepestQueue << ")" << endl;
+	text << "Requests: " << served << " (" << failed << " failed)" << endl;
+	text << "Mean time: " << (served > 0 ? totalMicros / served : 0) << " us, longest: "
+		<< longestMicros << " us" << endl;
+	return text.str();
+}
+
+/*******************************************************************************************
+*	Function Name:			serverRequest
+*	Purpose:				Connects to a server, sends one request and waits for its reply;
+*							on Linux a payload of SERVER_SHARED_MIN bytes or more is passed in
+*							a sealed memfd, and so is the reply to it
+*	Input Parameters:		string socketPath		the server's socket
+*							char op					the request
+*							string model			the model's name
+*							vector payload			the request's payload
+*							vector reply			the reply's payload
+*	Return value:			bool					false if the server could not be reached
+*													or answered with an error
+********************************************************************************************/
+bool serverRequest(const string& socketPath, char op, const string& model,
+	const vector<unsigned char>& payload, vector<unsigned char>& reply)
+{
+#ifdef _WIN32
+	cerr << "The server needs Unix domain sockets, which this platform does not have" << endl;
+	return false;
+#else
+	if (model.size() > 255 || payload.size() > SERVER_MAX_PAYLOAD)
+	{
+		cerr << "The model name or payload is too long" << endl;
+		return false;
+	}
+	sockaddr_un address;
+	if (!socketAddress(socketPath, address))
+		return false;
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0 || connect(server, (sockaddr*)&address, sizeof(address)) != 0)
+	{
+		cerr << "Error connecting to " << socketPath << ": " << strerror(errno) << endl;
+		if (server >= 0)
+			close(server);
+		return false;
+	}
+
+	//a large payload goes in a sealed memfd rather than through the socket, where it can
+	int passing = -1;
+	if (payload.size() >= SERVER_SHARED_MIN)
+	{
+		unsigned char* area = sharedArea(payload.size(), passing);
+		if (area != NULL)
+		{
+			memcpy(area, payload.data(), payload.size());
+			if (!sealArea(area, payload.size(), passing, payload.size()))
+			{
+				close(passing);
+				passing = -1;
+			}
+		}
+	}
+
+	vector<unsigned char> request(6 + model.size());
+	request[0] = (unsigned char)op | (passing >= 0 ? SERVER_SHARED : 0);
+	request[1] = (unsigned char)model.size();
+	memcpy(&request[2], model.data(), model.size());
+	putWord(&request[2 + model.size()], payload.size());
+	unsigned char header[5];
+	deque<int> passed;
+	bool ok = (passing >= 0) ? writePassing(server, request.data(), request.size(), passing)
+		: writeFull(server, request.data(), request.size()) && writeFull(server, payload.data(), payload.size());
+	ok = ok && readPassing(server, header, 5, passed);
+	size_t size = ok ? getWord(header + 1) : 0;
+	ok = ok && size <= SERVER_MAX_PAYLOAD;
+	reply.resize(size);
+	if (ok && (header[0] & SERVER_SHARED))
+	{
+		//the reply is in the memfd passed with its header
+		const unsigned char* mapped = passed.empty() ? NULL : mapShared(passed.front(), size);
+		ok = mapped != NULL;
+		if (ok)
+		{
+			memcpy(reply.data(), mapped, size);
+			munmap((void*)mapped, max(size, (size_t)1));
+		}
+	}
+	else
+		ok = ok && readFull(server, reply.data(), size);
+	for (size_t p = 0; p < passed.size(); p++)
+		close(passed[p]);
+	if (passing >= 0)
+		close(passing);
+	close(server);
+	if (!ok)
+	{
+		cerr << "The connection to " << socketPath << " broke" << endl;
+		return false;
+	}
+	if ((header[0] & ~SERVER_SHARED) != SERVER_DONE)
+	{
+		cerr << string(reply.begin(), reply.end()) << endl;
+		return false;
+	}
+	return true;
+#endif
+}
@@ -0,0 +1,154 @@
+/**************************************************************************************************
+*
+*   File name :			Server.h
+*
+*   Header file for the Server class, implemented in Server.cpp, a long running local process
+*	that keeps trained byte codecs in memory and codes for other processes over a Unix domain
+*	socket, so a service pays for training and table building once rather than per request.
+*	The listening thread polls every open connection and queues each request as soon as it has
+*	arrived in full, so a fixed pool of worker threads serves the requests of any number of
+*	connections, however long clients keep them open. A connection's requests are served one
+*	at a time, in order, and it is not polled while a worker has its request.
+*
+*	Each request is an op byte, the model name's length as one byte, the name, the payload's
+*	length as 4 little-endian bytes and the payload. Each reply is a status byte, 0 for done,
+*	the payload's length as 4 bytes and the payload, or an error message. Neither payload may
+*	be larger than SERVER_MAX_PAYLOAD, so an encode request whose code would not fit a reply
+*	is answered with an error.
+*
+*	On Linux a large payload need not be copied through the socket. Its op has SERVER_SHARED
+*	set, and instead of the payload the request passes a sealed memfd holding it; the server
+*	maps it, and codes an encode or decode reply straight into a memfd of its own, passed back
+*	with SERVER_SHARED set in the status.
+*		SERVER_TRAIN	payload: sample bytes		builds the named model from the sample
+*		SERVER_ENCODE	payload: bytes				reply: the byte count and code bits as 4 bytes
+*													each, then the code
+*		SERVER_DECODE	payload: an encode reply	reply: the bytes
+*		SERVER_STATS	no payload					reply: the server's statistics as text
+*		SERVER_STOP		no payload					stops the server
+*
+*	Only built where Unix domain sockets are, elsewhere run and request say so and fail.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Class Name:		Server
+*
+*	Structs:
+*		serverConnection			the bytes and memfds received on a connection and whether
+*									a worker has its request
+*		serverJob					a request received in full, its memfd if it passed one,
+*									and the connection it came on
+*
+*	Private data members:
+*		string socketPath			the socket the server listens on
+*		int workers					the threads serving requests
+*		int listener				the listening socket
+*		int wakeRead, wakeWrite		a pipe the workers write to, waking the listening thread
+*									when they finish with a connection
+*		map models					the trained models by name
+*		map connections				the open connections, used by the listening thread only
+*		deque<serverJob> waiting	requests not yet taken by a worker
+*		deque finished				connections a worker is done with, and whether they are
+*									still open
+*		mutex lock					guards models, waiting, finished and the statistics
+*		condition_variable ready	wakes a worker when a request waits
+*		bool stopping				set once the server is asked to stop
+*		unsigned long long served	requests served
+*		unsigned long long failed	requests answered with an error
+*		double totalMicros			time spent serving requests
+*		double longestMicros		the longest time one request took
+*		size_t deepestQueue			the most requests that have waited at once
+*
+*	Private member functions:
+*		void work					a worker's loop, taking and serving requests
+*		bool receive				reads what a connection has sent so far
+*		bool dispatch				queues a connection's request once it has arrived in full
+*		bool serve					carries out and answers one request
+*		void drop					closes a connection and any memfds it passed
+*		string stats				the statistics as text
+*
+*	Public member functions:
+*		Server				constructor for a server on a socket with a number of workers
+*		bool run			listens and serves until asked to stop
+*
+*	Functions:
+*		serverRequest				sends one request to a server and waits for the reply
+*
+****************************************************************************************************/
+#ifndef SERVER_H
+#define SERVER_H
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include "Codec.h"
+using namespace std;
+
+//request ops
+const char SERVER_TRAIN = 'T';
+const char SERVER_ENCODE = 'E';
+const char SERVER_DECODE = 'D';
+const char SERVER_STATS = 'S';
+const char SERVER_STOP = 'Q';
+
+//set in an op or status when the payload is in a passed memfd rather than on the socket
+const unsigned char SERVER_SHARED = 0x80;
+
+//largest payload a request or reply may carry
+const size_t SERVER_MAX_PAYLOAD = 1 << 26;
+
+//serverConnection struct holding what has arrived on a connection
+struct serverConnection
+{
+	vector<unsigned char> received;
+	deque<int> shared;
+	bool busy;
+};
+
+//serverJob struct holding one whole request
+struct serverJob
+{
+	int client;
+	vector<unsigned char> request;
+	int shared;
+};
+
+//server class for coding requests from other processes
+class Server
+{
+public:
+	Server(const string& socketPath, int workers);
+	bool run();
+
+private:
+	void work();
+	bool receive(int client, serverConnection& connection);
+	bool dispatch(int client, serverConnection& connection);
+	bool serve(const serverJob& job);
+	void drop(int client);
+	string stats();
+	string socketPath;
+	int workers;
+	int listener;
+	int wakeRead;
+	int wakeWrite;
+	map<string, shared_ptr<const byteCodec> > models;
+	map<int, serverConnection> connections;
+	deque<serverJob> waiting;
+	deque<pair<int, bool> > finished;
+	mutex lock;
+	condition_variable ready;
+	bool stopping;
+	unsigned long long served;
+	unsigned long long failed;
+	double totalMicros;
+	double longestMicros;
+	size_t deepestQueue;
+};
+
+bool serverRequest(const string& socketPath, char op, const string& model,
+	const vector<unsigned char>& payload, vector<unsigned char>& reply);
+#endif // !SERVER_H
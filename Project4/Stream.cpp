@@ -0,0 +1,617 @@
+/**************************************************************************************************
+*
+*   File name :			Stream.cpp
+*
+*	Implementation of the stream functions as defined in Stream.h. Messages go to standard
+*	error, since standard output may be carrying the stream itself.
+*
+*   Date Last Revised:	10/19/26
+****************************************************************************************************/
+#include "Stream.h"
+#include "AnsCodec.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <climits>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+using namespace std;
+
+//first bytes of a stream
+const char STREAM_MAGIC[4] = { 'H', 'U', 'F', 'S' };
+
+//kinds of chunk; Huffman chunks are written with their code in CHUNK_STREAMS streams, and
+//CODED_CHUNK, with it in one, is still read from older streams. A REUSE_CHUNK is coded with
+//the last Huffman table written before it and carries no table
+const unsigned char CODED_CHUNK = 0;
+const unsigned char STORED_CHUNK = 1;
+const unsigned char ANS_CHUNK = 2;
+const unsigned char INTERLEAVED_CHUNK = 3;
+const unsigned char REUSE_CHUNK = 4;
+
+//streams a Huffman chunk's code is split into, so decoding can follow them all at once
+const int CHUNK_STREAMS = 4;
+
+//bytes of code lengths in a Huffman chunk
+const int LENGTH_BYTES = 256;
+
+//bytes of shares in a tANS chunk; 256 byte values always take the smallest table,
+//so every share fits in 2 bytes
+const int SHARE_BYTES = 2 * 256;
+
+//the coder for a chunk's bytes
+typedef entropyCodec<uint8_t, 256> chunkCodec;
+
+//buffers of each kind passing between the threads of compressStream and decompressStream,
+//so one is filled while the one before it is used
+const int PIPE_BUFFERS = 2;
+
+//most bits one byte can take in a chunk; a tANS chunk spends at most its table's log2 on
+//each byte and once more on its final state, which is far less
+const size_t MAX_BYTE_BITS = codec<uint8_t, 256>::MAX_LENGTH;
+
+//writes a number as 4 bytes, least significant first
+static bool putWord(FILE* out, size_t value)
+{
+	unsigned char bytes[4];
+	for (int b = 0; b < 4; b++)
+		bytes[b] = (unsigned char)(value >> (8 * b));
+	return fwrite(bytes, 1, 4, out) == 4;
+}
+
+//adds a number as 4 bytes onto the end of a chunk's record
+static void putWord(accountedVector<unsigned char>& out, size_t value)
+{
+	for (int b = 0; b < 4; b++)
+		out.push_back((unsigned char)(value >> (8 * b)));
+}
+
+//overwrites 4 bytes of a record, saved by putWord, with a number known only later
+static void setWord(unsigned char* at, size_t value)
+{
+	for (int b = 0; b < 4; b++)
+		at[b] = (unsigned char)(value >> (8 * b));
+}
+
+//reads a number written by putWord, returns false if the stream ends first
+static bool getWord(FILE* in, size_t& value)
+{
+	unsigned char bytes[4];
+	if (fread(bytes, 1, 4, in) != 4)
+		return false;
+	value = 0;
+	for (int b = 0; b < 4; b++)
+		value |= (size_t)bytes[b] << (8 * b);
+	return true;
+}
+
+//the last Huffman table a stream has carried, which a REUSE_CHUNK codes with
+struct lastTable
+{
+	explicit lastTable(MemoryAccount* account) : model(account), valid(false) {}
+	byteCodec model;
+	bool valid;
+};
+
+//pipeBuffer struct holding a chunk or record and the bytes of it in use
+struct pipeBuffer
+{
+	explicit pipeBuffer(MemoryAccount* account)
+		: bytes(accountedAllocator<unsigned char>(account)), size(0) {}
+	accountedVector<unsigned char> bytes;
+	size_t size;
+};
+
+//pipeQueue struct holding buffers one thread hands another. Only PIPE_BUFFERS buffers of a
+//kind exist, so a queue never holds more, and a thread waits for a buffer to come back
+//rather than making one
+struct pipeQueue
+{
+	mutex lock;
+	condition_variable changed;
+	deque<pipeBuffer*> buffers;
+	bool closed = false;
+};
+
+//hands a buffer on
+static void putBuffer(pipeQueue& queue, pipeBuffer* buffer)
+{
+	lock_guard<mutex> guard(queue.lock);
+	queue.buffers.push_back(buffer);
+	queue.changed.notify_one();
+}
+
+//waits for the next buffer, returns NULL once the queue is closed and empty
+static pipeBuffer* takeBuffer(pipeQueue& queue)
+{
+	unique_lock<mutex> guard(queue.lock);
+	queue.changed.wait(guard, [&queue]() { return queue.closed || !queue.buffers.empty(); });
+	if (queue.buffers.empty())
+		return NULL;
+	pipeBuffer* buffer = queue.buffers.front();
+	queue.buffers.pop_front();
+	return buffer;
+}
+
+//tells the thread taking from a queue that no more buffers are coming
+static void closeQueue(pipeQueue& queue)
+{
+	lock_guard<mutex> guard(queue.lock);
+	queue.closed = true;
+	queue.changed.notify_all();
+}
+
+/*******************************************************************************************
+*	Function Name:			codeChunk
+*	Purpose:				Codes one chunk into its record: its size, kind and payload.
+*							The chunk's histogram prices each way of writing it, headers
+*							included: the last Huffman table again, a new Huffman table,
+*							a new tANS table or the bytes as they are. The cheapest is
+*							written, and stored instead if its code comes out no smaller
+*	Input Parameters:		const uint8_t* data		the chunk
+*							size_t size				its bytes
+*							chunkCodec model		the coder, counted again for this chunk
+*							lastTable last			the last Huffman table, replaced when
+*													a new one is written
+*							accountedVector record	the record, replaced
+*	Return value:			none
+********************************************************************************************/
+static void codeChunk(const uint8_t* data, size_t size, chunkCodec& model, lastTable& last,
+	accountedVector<unsigned char>& record)
+{
+	model.reset();
+	model.count(data, size);
+	model.build();
+	unsigned long long freq[256] = { 0 };
+	for (size_t i = 0; i < size; i++)
+		freq[data[i]]++;
+
+	//each option's bits; the last table only serves when it codes every byte present
+	const size_t streamWords = 4 * CHUNK_STREAMS;
+	unsigned long long reuseCost = ULLONG_MAX;
+	if (last.valid)
+	{
+		reuseCost = 8 * streamWords;
+		for (int s = 0; s < 256 && reuseCost != ULLONG_MAX; s++)
+		{
+			int len = last.model.codeLength((uint8_t)s);
+			if (freq[s] > 0)
+				reuseCost = (len == 0) ? ULLONG_MAX : reuseCost + freq[s] * len;
+		}
+	}
+	unsigned long long huffmanCost = model.codeBits(HUFFMAN_BACKEND) + 8 * (LENGTH_BYTES + streamWords);
+	unsigned long long ansCost = model.codeBits(ANS_BACKEND) + 8 * (SHARE_BYTES + 4);
+	unsigned char kind = STORED_CHUNK;
+	unsigned long long best = 8ULL * size;
+	if (reuseCost < best)
+	{
+		kind = REUSE_CHUNK;
+		best = reuseCost;
+	}
+	if (huffmanCost < best)
+	{
+		kind = INTERLEAVED_CHUNK;
+		best = huffmanCost;
+	}
+	if (ansCost < best)
+		kind = ANS_CHUNK;
+
+	//the header, with the bit counts filled in once the code is written after them
+	record.clear();
+	putWord(record, size);
+	record.push_back(kind);
+	size_t bits = 0;
+	if (kind == ANS_CHUNK)
+	{
+		model.setBackend(ANS_BACKEND);
+		for (int s = 0; s < 256; s++)
+		{
+			record.push_back((unsigned char)model.share((uint8_t)s));
+			record.push_back((unsigned char)(model.share((uint8_t)s) >> 8));
+		}
+		size_t words = record.size();
+		putWord(record, 0);
+		bits = model.encode(data, size, record);
+		setWord(&record[words], bits);
+	}
+	else if (kind != STORED_CHUNK)
+	{
+		if (kind == INTERLEAVED_CHUNK)
+		{
+			for (int s = 0; s < 256; s++)
+				record.push_back((unsigned char)model.codeLength((uint8_t)s));
+		}
+		size_t words = record.size();
+		size_t streamBits[CHUNK_STREAMS];
+		record.resize(words + streamWords);
+		bits = (kind == REUSE_CHUNK)
+			? last.model.encodeStreams(data, size, CHUNK_STREAMS, record, streamBits)
+			: model.encodeStreams(data, size, CHUNK_STREAMS, record, streamBits);
+		for (int k = 0; k < CHUNK_STREAMS && bits > 0; k++)
+			setWord(&record[words + 4 * k], streamBits[k]);
+	}
+
+	//the bytes as they are when the code failed or saves nothing
+	if (kind == STORED_CHUNK || bits == 0 || record.size() >= size + 5)
+	{
+		record.resize(4);
+		record.push_back(STORED_CHUNK);
+		record.insert(record.end(), data, data + size);
+	}
+
+	//a new Huffman table that was written is the one the next chunks may reuse
+	if (record[4] == INTERLEAVED_CHUNK)
+		last.valid = last.model.setLengths(&record[5]);
+}
+
+/*******************************************************************************************
+*	Function Name:			compressStream
+*	Purpose:				Codes everything read from in onto out a chunk at a time, each
+*							chunk written the cheapest way codeChunk finds. A thread reads
+*							the next chunk and another writes the last record while this one
+*							codes, handing PIPE_BUFFERS reused chunks and records between
+*							them, so the time taken nears the longest of reading, coding and
+*							writing rather than their sum
+*	Input Parameters:		FILE* in			the open input, read to its end
+*							FILE* out			the open output
+*							MemoryAccount* account	the account the buffers and tables
+*												allocate through, NULL for none
+*	Return value:			bool				false if reading or writing failed
+********************************************************************************************/
+bool compressStream(FILE* in, FILE* out, MemoryAccount* account)
+{
+	if (fwrite(STREAM_MAGIC, 1, 4, out) != 4)
+	{
+		cerr << "Error writing the stream" << endl;
+		return false;
+	}
+	vector<pipeBuffer> chunks(PIPE_BUFFERS, pipeBuffer(account));
+	vector<pipeBuffer> records(PIPE_BUFFERS, pipeBuffer(account));
+	pipeQueue emptyChunks, readChunks, emptyRecords, codedRecords;
+	for (int b = 0; b < PIPE_BUFFERS; b++)
+	{
+		chunks[b].bytes.resize(STREAM_CHUNK);
+		putBuffer(emptyChunks, &chunks[b]);
+		putBuffer(emptyRecords, &records[b]);
+	}
+
+	//a failed write stops the reading, and everything read after it is dropped
+	atomic<bool> failed(false);
+	bool readFailed = false;
+	bool writeFailed = false;
+
+	//fread waits for a full chunk, so small writes down a pipe still make full chunks
+	thread reader([&]()
+	{
+		pipeBuffer* chunk;
+		while (!failed && (chunk = takeBuffer(emptyChunks)) != NULL)
+		{
+			chunk->size = fread(chunk->bytes.data(), 1, STREAM_CHUNK, in);
+			if (chunk->size == 0)
+				break;
+			putBuffer(readChunks, chunk);
+		}
+		readFailed = ferror(in) != 0;
+		closeQueue(readChunks);
+	});
+	thread writer([&]()
+	{
+		pipeBuffer* record;
+		while ((record = takeBuffer(codedRecords)) != NULL)
+		{
+			if (!writeFailed && fwrite(record->bytes.data(), 1, record->size, out) != record->size)
+			{
+				writeFailed = true;
+				failed = true;
+			}
+			putBuffer(emptyRecords, record);
+		}
+	});
+
+	//the chunks coded in order here, the last table carried from one to the next; the threads
+	//are stopped before anything thrown goes on
+	exception_ptr thrown;
+	try
+	{
+		chunkCodec model(HUFFMAN_BACKEND, account);
+		lastTable last(account);
+		pipeBuffer* chunk;
+		while ((chunk = takeBuffer(readChunks)) != NULL)
+		{
+			pipeBuffer* record = takeBuffer(emptyRecords);
+			codeChunk(chunk->bytes.data(), chunk->size, model, last, record->bytes);
+			record->size = record->bytes.size();
+			putBuffer(emptyChunks, chunk);
+			putBuffer(codedRecords, record);
+		}
+	}
+	catch (...)
+	{
+		thrown = current_exception();
+		failed = true;
+	}
+	closeQueue(emptyChunks);
+	closeQueue(codedRecords);
+	reader.join();
+	writer.join();
+	if (thrown)
+		rethrow_exception(thrown);
+	if (readFailed)
+	{
+		cerr << "Error reading the input" << endl;
+		return false;
+	}
+
+	//a chunk of size 0 ends the stream
+	if (writeFailed || !putWord(out, 0) || fflush(out) != 0)
+	{
+		cerr << "Error writing the stream" << endl;
+		return false;
+	}
+	return true;
+}
+
+/*******************************************************************************************
+*	Function Name:			decodeChunks
+*	Purpose:				Decodes the chunks of a stream, after its magic, each into a
+*							chunk taken from empty and handed on to decoded, up to the
+*							chunk of size 0 that ends it
+*	Input Parameters:		FILE* in			the open stream
+*							pipeQueue empty		chunks to decode into
+*							pipeQueue decoded	the decoded chunks, in order
+*							MemoryAccount* account	the account the code and tables
+*												allocate through, NULL for none
+*	Return value:			string				why the stream could not be decoded,
+*												empty if it was
+********************************************************************************************/
+static string decodeChunks(FILE* in, pipeQueue& empty, pipeQueue& decoded,
+	MemoryAccount* account)
+{
+	accountedVector<unsigned char> code((accountedAllocator<unsigned char>(account)));
+	unsigned char table[SHARE_BYTES];
+	unsigned shares[256];
+	chunkCodec model(HUFFMAN_BACKEND, account);
+	lastTable last(account);
+	size_t size;
+	while (true)
+	{
+		if (!getWord(in, size))
+			return "The stream ends before its last chunk";
+		if (size == 0)
+			return "";
+		if (size > STREAM_CHUNK)
+			return "A chunk is larger than " + to_string(STREAM_CHUNK) + " bytes";
+		pipeBuffer* chunk = takeBuffer(empty);
+
+		int kind = fgetc(in);
+		bool ok = (kind == STORED_CHUNK || kind == CODED_CHUNK || kind == ANS_CHUNK
+			|| kind == INTERLEAVED_CHUNK || (kind == REUSE_CHUNK && last.valid));
+		if (kind == STORED_CHUNK)
+			ok = fread(chunk->bytes.data(), 1, size, in) == size;
+		else if (kind == INTERLEAVED_CHUNK || kind == REUSE_CHUNK)
+		{
+			//each stream codes at most a part of the chunk, and starts on a new byte
+			size_t part = (size + CHUNK_STREAMS - 1) / CHUNK_STREAMS;
+			size_t streamBits[CHUNK_STREAMS];
+			size_t bytes = 0;
+			if (kind == INTERLEAVED_CHUNK)
+			{
+				ok = fread(table, 1, LENGTH_BYTES, in) == LENGTH_BYTES && last.model.setLengths(table);
+				last.valid = ok;
+			}
+			for (int k = 0; k < CHUNK_STREAMS && ok; k++)
+			{
+				ok = getWord(in, streamBits[k]) && streamBits[k] <= part * MAX_BYTE_BITS;
+				bytes += (streamBits[k] + 7) / 8;
+			}
+			if (ok)
+				code.resize(bytes);
+			ok = ok && fread(code.data(), 1, code.size(), in) == code.size();
+			ok = ok && last.model.decodeStreams(code.data(), streamBits, CHUNK_STREAMS,
+				chunk->bytes.data(), size) == size;
+		}
+		else if (ok)
+		{
+			size_t bits = 0;
+			if (kind == ANS_CHUNK)
+			{
+				ok = fread(table, 1, SHARE_BYTES, in) == SHARE_BYTES;
+				for (int s = 0; s < 256; s++)
+					shares[s] = table[2 * s] | ((unsigned)table[2 * s + 1] << 8);
+				ok = ok && model.setShares(shares);
+				model.setBackend(ANS_BACKEND);
+			}
+			else
+			{
+				ok = fread(table, 1, LENGTH_BYTES, in) == LENGTH_BYTES && model.setLengths(table);
+				model.setBackend(HUFFMAN_BACKEND);
+			}
+			ok = ok && getWord(in, bits) && bits <= size * MAX_BYTE_BITS;
+			if (ok)
+				code.resize((bits + 7) / 8);
+			ok = ok && fread(code.data(), 1, code.size(), in) == code.size();
+			ok = ok && model.decode(code.data(), bits, chunk->bytes.data(), size) == size;
+		}
+		if (!ok)
+			return "The stream is damaged";
+		chunk->size = size;
+		putBuffer(decoded, chunk);
+	}
+}
+
+/*******************************************************************************************
+*	Function Name:			decompressStream
+*	Purpose:				Decodes a stream written by compressStream from in onto out,
+*							a thread writing each chunk while the next is decoded into
+*							another of PIPE_BUFFERS reused chunks
+*	Input Parameters:		FILE* in			the open stream
+*							FILE* out			the open output
+*							MemoryAccount* account	the account the buffers and tables
+*												allocate through, NULL for none
+*	Return value:			bool				false if the stream is damaged or ends
+*												before its last chunk
+********************************************************************************************/
+bool decompressStream(FILE* in, FILE* out, MemoryAccount* account)
+{
+	char magic[4];
+	if (fread(magic, 1, 4, in) != 4 || memcmp(magic, STREAM_MAGIC, 4) != 0)
+	{
+		cerr << "The input is not a stream" << endl;
+		return false;
+	}
+	vector<pipeBuffer> chunks(PIPE_BUFFERS, pipeBuffer(account));
+	pipeQueue emptyChunks, decodedChunks;
+	for (int b = 0; b < PIPE_BUFFERS; b++)
+	{
+		chunks[b].bytes.resize(STREAM_CHUNK);
+		putBuffer(emptyChunks, &chunks[b]);
+	}
+	bool writeFailed = false;
+	thread writer([&]()
+	{
+		pipeBuffer* chunk;
+		while ((chunk = takeBuffer(decodedChunks)) != NULL)
+		{
+			if (!writeFailed && fwrite(chunk->bytes.data(), 1, chunk->size, out) != chunk->size)
+				writeFailed = true;
+			putBuffer(emptyChunks, chunk);
+		}
+	});
+
+	//the writer is stopped before anything thrown goes on
+	string error;
+	exception_ptr thrown;
+	try
+	{
+		error = decodeChunks(in, emptyChunks, decodedChunks, account);
+	}
+	catch (...)
+	{
+		thrown = current_exception();
+	}
+	closeQueue(decodedChunks);
+	writer.join();
+	if (thrown)
+		rethrow_exception(thrown);
+	if (!error.empty())
+	{
+		cerr << error << endl;
+		return false;
+	}
+	if (writeFailed || fflush(out) != 0)
+	{
+		cerr << "Error writing the output" << endl;
+		return false;
+	}
+	return true;
+}
+
+//whether two open files hold the same bytes, read from where each is
+static bool sameFiles(FILE* a, FILE* b, MemoryAccount* account)
+{
+	accountedVector<unsigned char> first(STREAM_CHUNK, 0,
+		accountedAllocator<unsigned char>(account));
+	accountedVector<unsigned char> second(STREAM_CHUNK, 0, first.get_allocator());
+	while (true)
+	{
+		size_t size = fread(first.data(), 1, STREAM_CHUNK, a);
+		if (fread(second.data(), 1, STREAM_CHUNK, b) != size || memcmp(first.data(), second.data(), size) != 0)
+			return false;
+		if (size == 0)
+			return true;
+	}
+}
+
+/*******************************************************************************************
+*	Function Name:			checkStream
+*	Purpose:				Checks that everything read from in comes back unchanged from
+*							each chunk's Huffman code, in one stream and split into
+*							streams, and its tANS code, and from a whole stream
+*							written to a temporary file and decoded into another, printing
+*							the bits each coder took
+*	Input Parameters:		FILE* in			the open input, read to its end
+*							MemoryAccount* account	the account the buffers and tables
+*												allocate through, NULL for none
+*	Return value:			bool				false if anything did not come back
+********************************************************************************************/
+bool checkStream(FILE* in, MemoryAccount* account)
+{
+	FILE* original = tmpfile();
+	FILE* coded = tmpfile();
+	FILE* decoded = tmpfile();
+	accountedAllocator<uint8_t> bytesAllocator(account);
+	accountedVector<uint8_t> chunk(STREAM_CHUNK, 0, bytesAllocator);
+	accountedVector<uint8_t> back(STREAM_CHUNK, 0, bytesAllocator);
+	accountedVector<unsigned char> code(bytesAllocator);
+	chunkCodec model(HUFFMAN_BACKEND, account);
+	const backend coders[3] = { HUFFMAN_BACKEND, ANS_BACKEND, HUFFMAN_BACKEND };
+	const char* names[3] = { "Huffman", "tANS", "Huffman in streams" };
+	unsigned long long totals[3] = { 0, 0, 0 };
+	size_t streamBits[CHUNK_STREAMS];
+	unsigned long long bytes = 0;
+	bool ok = original != NULL && coded != NULL && decoded != NULL;
+
+	//each chunk through each coder on its own
+	size_t size;
+	while (ok && (size = fread(chunk.data(), 1, STREAM_CHUNK, in)) > 0)
+	{
+		ok = fwrite(chunk.data(), 1, size, original) == size;
+		model.reset();
+		model.count(chunk.data(), size);
+		model.build();
+		for (int c = 0; c < 3 && ok; c++)
+		{
+			model.setBackend(coders[c]);
+			code.clear();
+			size_t bits = 0;
+			if (c < 2)
+			{
+				bits = model.encode(chunk.data(), size, code);
+				ok = bits > 0 && model.decode(code.data(), bits, back.data(), size) == size;
+			}
+			else
+			{
+				bits = model.encodeStreams(chunk.data(), size, CHUNK_STREAMS, code, streamBits);
+				ok = bits > 0
+					&& model.decodeStreams(code.data(), streamBits, CHUNK_STREAMS, back.data(), size) == size;
+			}
+			ok = ok && memcmp(chunk.data(), back.data(), size) == 0;
+			if (!ok)
+				cout << "A chunk did not come back from " << names[c] << endl;
+			totals[c] += bits;
+		}
+		bytes += size;
+	}
+
+	//the whole stream, coded and decoded again
+	if (ok)
+	{
+		rewind(original);
+		ok = compressStream(original, coded, account);
+		rewind(coded);
+		ok = ok && decompressStream(coded, decoded, account);
+		rewind(original);
+		rewind(decoded);
+		ok = ok && sameFiles(original, decoded, account);
+		if (!ok)
+			cout << "The stream did not come back" << endl;
+	}
+	if (ok)
+	{
+		cout << bytes << " bytes came back from each coder and the stream" << endl;
+		for (int c = 0; c < 3; c++)
+			cout << "    " << names[c] << ": " << totals[c] << " bits" << endl;
+		cout << "    stream: " << ftell(coded) << " bytes" << endl;
+	}
+	FILE* files[3] = { original, coded, decoded };
+	for (int f = 0; f < 3; f++)
+	{
+		if (files[f] != NULL)
+			fclose(files[f]);
+	}
+	return ok;
+}
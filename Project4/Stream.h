@@ -0,0 +1,46 @@
+/**************************************************************************************************
+*
+*   File name :			Stream.h
+*
+*   Header file for the stream functions, implemented in Stream.cpp, which code any bytes from
+*	one open file, such as standard input or a pipe, to another without naming or staging files,
+*	so the program can sit in a pipeline as huffman -c or huffman -d. The input is cut into
+*	chunks of up to STREAM_CHUNK bytes, each coded with its own table and framed with its size,
+*	and a chunk of size 0 ends the stream, so no terminating character is needed and any byte
+*	can be coded. Each chunk is priced from its histogram four ways, headers included: coded
+*	with the last Huffman table the stream carried, with a new Huffman table, with a new tANS
+*	table, or stored, and the cheapest is written, so the coding follows statistics that drift
+*	without paying for a table on every chunk.
+*
+*	A stream starts with STREAM_MAGIC. Each chunk is its byte count as 4 little-endian bytes,
+*	then, if it is not 0, a kind byte. A Huffman chunk has the code length of every byte value,
+*	the number of code bits of each of its 4 streams as 4 bytes, and the streams' code, each
+*	coding a quarter of the chunk and starting on a new byte, so decoding follows all four at
+*	once. A tANS chunk has the share of the states of every byte value as 2 bytes, the number
+*	of code bits as 4 bytes and the code. A reuse chunk is a Huffman chunk without the code
+*	lengths, coded with those of the last Huffman chunk. A stored chunk has the bytes themselves.
+*
+*	Each function takes an optional MemoryAccount that its chunk buffers and code tables
+*	allocate through, so a caller can budget what coding a stream takes.
+*
+*   Date Last Revised:	10/19/26
+*
+*	Functions:
+*		compressStream			codes everything read from one file onto another
+*		decompressStream		decodes a stream written by compressStream
+*		checkStream				checks that a file comes back from both coders and a stream
+*
+****************************************************************************************************/
+#ifndef STREAM_H
+#define STREAM_H
+#include <cstdio>
+#include "Memory.h"
+using namespace std;
+
+//most bytes coded with one table
+const size_t STREAM_CHUNK = 1 << 20;
+
+bool compressStream(FILE* in, FILE* out, MemoryAccount* account = NULL);
+bool decompressStream(FILE* in, FILE* out, MemoryAccount* account = NULL);
+bool checkStream(FILE* in, MemoryAccount* account = NULL);
+#endif // !STREAM_H